@@ -2,6 +2,30 @@
 
 %{
 #include "frida_core.h"
+#include "fk_event_queue.h"
+#include "fk_device_registry.h"
+#include "fk_fanout.h"
+#include "fk_remote_pool.h"
+#include "fk_endpoint.h"
+#include "fk_portal.h"
+#include "fk_agent.h"
+#include "fk_spawn_pipeline.h"
+#include "fk_child_follower.h"
+#include "fk_spawn_options.h"
+#include "fk_stdio.h"
+#include "fk_crash_collector.h"
+#include "fk_injection.h"
+#include "fk_device_query.h"
+#include "fk_icon.h"
+#include "fk_app_tracker.h"
+#include "fk_bus.h"
+#include "fk_channel.h"
+#include "fk_forwarder.h"
+#include "fk_service.h"
+#include "fk_file_monitor.h"
+#include "fk_hot_reload.h"
+#include "fk_session.h"
+#include "fk_auth_service.h"
 %}
 
 // Map GLib Primitive Types to Java Types
@@ -9,6 +33,13 @@ typedef unsigned int guint;
 typedef int gint;
 typedef char gchar;
 typedef void* gpointer;
+typedef const void* gconstpointer;
+typedef unsigned long gsize;
+typedef unsigned short guint16;
+typedef long long gint64;
+typedef int gboolean;
+
+%apply bool { gboolean };
 
 // GError Handling
 typedef struct _GError GError;
@@ -18,6 +49,14 @@ typedef struct _GError GError;
     $1 = &temp;
 }
 
+// A GError set by any wrapped call is raised as a RuntimeException carrying its
+// message, instead of being dropped with a NULL/zero result.
+%typemap(argout) GError **error {
+    if (*$1 != NULL) {
+        SWIG_JavaThrowException(jenv, SWIG_JavaRuntimeException, (*$1)->message);
+    }
+}
+
 %typemap(freearg) GError **error {
     if (*$1 != NULL) {
         g_error_free(*$1);
@@ -31,6 +70,79 @@ typedef struct _GCancellable GCancellable;
     $1 = NULL;
 }
 
+// GBytes Handling: byte[] in, byte[] out. Returned GBytes are owned by the
+// caller, so they are released once copied into the Java array.
+typedef struct _GBytes GBytes;
+
+%typemap(jni) GBytes * "jbyteArray"
+%typemap(jtype) GBytes * "byte[]"
+%typemap(jstype) GBytes * "byte[]"
+%typemap(javain) GBytes * "$javainput"
+%typemap(javaout) GBytes * {
+    return $jnicall;
+  }
+
+%typemap(in) GBytes * {
+    $1 = NULL;
+    if ($input != NULL) {
+        jsize length = jenv->GetArrayLength($input);
+        jbyte *elements = jenv->GetByteArrayElements($input, NULL);
+        $1 = g_bytes_new(elements, (gsize) length);
+        jenv->ReleaseByteArrayElements($input, elements, JNI_ABORT);
+    }
+}
+
+%typemap(freearg) GBytes * {
+    if ($1 != NULL) {
+        g_bytes_unref($1);
+    }
+}
+
+%typemap(out) GBytes * {
+    $result = NULL;
+    if ($1 != NULL) {
+        gsize size;
+        gconstpointer data = g_bytes_get_data($1, &size);
+        $result = jenv->NewByteArray((jsize) size);
+        jenv->SetByteArrayRegion($result, 0, (jsize) size, (const jbyte *) data);
+        g_bytes_unref($1);
+    }
+}
+
+// Direct ByteBuffer Handling: native code reads the buffer in place, from
+// address 0 up to its capacity.
+%typemap(jni) (gconstpointer buffer, gsize size) "jobject"
+%typemap(jtype) (gconstpointer buffer, gsize size) "java.nio.ByteBuffer"
+%typemap(jstype) (gconstpointer buffer, gsize size) "java.nio.ByteBuffer"
+%typemap(javain) (gconstpointer buffer, gsize size) "$javainput"
+
+%typemap(in) (gconstpointer buffer, gsize size) {
+    $1 = jenv->GetDirectBufferAddress($input);
+    $2 = (gsize) jenv->GetDirectBufferCapacity($input);
+    if ($1 == NULL) {
+        SWIG_JavaThrowException(jenv, SWIG_JavaIllegalArgumentException, "Expected a direct ByteBuffer");
+        return $null;
+    }
+}
+
+%apply (gconstpointer buffer, gsize size) { (gpointer buffer, gsize size) };
+
+// Native memory handed out as a direct ByteBuffer without copying; the
+// buffer is only valid while the object that owns the memory is alive.
+%typemap(jni) FkDirectBuffer "jobject"
+%typemap(jtype) FkDirectBuffer "java.nio.ByteBuffer"
+%typemap(jstype) FkDirectBuffer "java.nio.ByteBuffer"
+%typemap(javaout) FkDirectBuffer {
+    return $jnicall;
+  }
+
+// Empty native data still yields a (zero-capacity) buffer, never null.
+%typemap(out) FkDirectBuffer {
+    static guint8 fk_empty_buffer;
+    $result = jenv->NewDirectByteBuffer($1.data != NULL ? (void *) $1.data : (void *) &fk_empty_buffer,
+                                        $1.data != NULL ? (jlong) $1.size : 0);
+}
+
 // Frida Initialization Functions
 extern void frida_init(void);
 extern void frida_shutdown(void);
@@ -78,6 +190,17 @@ extern FridaDeviceType frida_device_get_dtype(FridaDevice* self);
 extern void frida_unref(gpointer obj);
 %delobject frida_unref;
 
+// frida_unref() takes a gpointer, which Java can't pass typed handles to;
+// this declares a typed alias for objects the Kotlin side owns.
+%define FK_DECLARE_UNREF(TYPE, NAME)
+%delobject NAME;
+%inline %{
+static void NAME(TYPE *self) {
+    frida_unref(self);
+}
+%}
+%enddef
+
 // Application Enumeration
 typedef struct _FridaApplicationList FridaApplicationList;
 typedef struct _FridaApplicationQueryOptions FridaApplicationQueryOptions;
@@ -142,9 +265,452 @@ extern FridaProcess* frida_process_list_get(FridaProcessList* self, gint index);
 extern guint frida_process_get_pid(FridaProcess* self);
 extern const gchar* frida_process_get_name(FridaProcess* self);
 
+// Enumeration with parameters, one buffer per list
+extern GBytes* fk_device_enumerate_applications(FridaDevice* device, FridaScope scope, const gchar* keys, GError** error);
+extern GBytes* fk_device_enumerate_processes(FridaDevice* device, FridaScope scope, const gchar* keys, GError** error);
+extern GBytes* fk_device_find_process(FridaDevice* device, const gchar* name, guint pid, gint timeout_ms, guint max_age_ms, GError** error);
+extern void fk_device_forget_processes(FridaDevice* device);
+
 // Frida Utilities
 %newobject frida_device_manager_enumerate_devices_sync;
 %newobject frida_device_list_get;
 %newobject frida_device_enumerate_applications_sync;
 %newobject frida_application_query_options_new;
 %newobject frida_device_enumerate_processes_sync;
+
+// Event Queues
+typedef struct _FkEventQueue FkEventQueue;
+
+extern GBytes* fk_event_queue_drain(FkEventQueue* self, gint timeout_ms);
+extern guint fk_event_queue_pending(FkEventQueue* self);
+extern void fk_event_queue_close(FkEventQueue* self);
+
+// Device Registry
+typedef struct _FkDeviceRegistry FkDeviceRegistry;
+
+extern FkDeviceRegistry* fk_device_registry_new(FridaDeviceManager* manager);
+extern void fk_device_registry_free(FkDeviceRegistry* self);
+extern FridaDevice* fk_device_registry_lookup(FkDeviceRegistry* self, const gchar* id);
+extern GBytes* fk_device_registry_snapshot(FkDeviceRegistry* self);
+extern FkEventQueue* fk_device_registry_get_changes(FkDeviceRegistry* self);
+extern GBytes* fk_device_registry_query_system_parameters(FkDeviceRegistry* self, const gchar* id, GError** error);
+extern void fk_device_registry_invalidate(FkDeviceRegistry* self);
+extern void fk_device_unref(FridaDevice* device);
+
+%newobject fk_device_registry_new;
+%newobject fk_device_registry_lookup;
+%delobject fk_device_registry_free;
+%delobject fk_device_unref;
+
+// Multi-Device Fan-Out
+typedef enum {
+    FK_FANOUT_ENUMERATE_APPLICATIONS,
+    FK_FANOUT_ENUMERATE_PROCESSES
+} FkFanOutQuery;
+
+extern GBytes* fk_fanout_run(FkDeviceRegistry* registry, FkFanOutQuery query, FridaScope scope, gint timeout_ms);
+
+// Remote Device Pool
+typedef struct _FkRemotePool FkRemotePool;
+
+extern FkRemotePool* fk_remote_pool_new(FridaDeviceManager* manager);
+extern void fk_remote_pool_free(FkRemotePool* self);
+extern FridaDevice* fk_remote_pool_add(
+    FkRemotePool* self,
+    const gchar* address,
+    const gchar* certificate,
+    const gchar* origin,
+    const gchar* token,
+    gint keepalive_interval,
+    GError** error
+);
+extern void fk_remote_pool_remove(FkRemotePool* self, const gchar* address, GError** error);
+extern FkEventQueue* fk_remote_pool_get_events(FkRemotePool* self);
+
+%newobject fk_remote_pool_new;
+%newobject fk_remote_pool_add;
+%delobject fk_remote_pool_free;
+
+// Authentication
+typedef struct _FkAuthService FkAuthService;
+
+extern FkAuthService* fk_auth_service_new(guint capacity, guint ttl_ms);
+extern void fk_auth_service_free(FkAuthService* self);
+extern void fk_auth_service_complete(FkAuthService* self, guint id, const gchar* session_info);
+extern void fk_auth_service_forget_all(FkAuthService* self);
+extern FkEventQueue* fk_auth_service_get_requests(FkAuthService* self);
+
+%newobject fk_auth_service_new;
+%delobject fk_auth_service_free;
+
+// Endpoint Parameters
+typedef struct _FridaEndpointParameters FridaEndpointParameters;
+
+extern FridaEndpointParameters* fk_endpoint_parameters_new(
+    const gchar* address,
+    guint16 port,
+    const gchar* certificate,
+    const gchar* origin,
+    const gchar* token,
+    FkAuthService* auth_service,
+    const gchar* asset_root,
+    GError** error
+);
+
+extern const gchar* frida_endpoint_parameters_get_address(FridaEndpointParameters* self);
+extern guint16 frida_endpoint_parameters_get_port(FridaEndpointParameters* self);
+
+%newobject fk_endpoint_parameters_new;
+
+// Control Service
+typedef struct _FridaControlService FridaControlService;
+typedef struct _FridaControlServiceOptions FridaControlServiceOptions;
+
+extern FridaControlServiceOptions* frida_control_service_options_new(void);
+extern void frida_control_service_options_set_sysroot(FridaControlServiceOptions* self, const gchar* value);
+extern void frida_control_service_options_set_enable_preload(FridaControlServiceOptions* self, gboolean value);
+extern void frida_control_service_options_set_report_crashes(FridaControlServiceOptions* self, gboolean value);
+
+extern FridaControlService* frida_control_service_new(
+    FridaEndpointParameters* endpoint_params,
+    FridaControlServiceOptions* options
+);
+
+extern void frida_control_service_start_sync(FridaControlService* self, GCancellable* cancellable, GError** error);
+extern void frida_control_service_stop_sync(FridaControlService* self, GCancellable* cancellable, GError** error);
+
+%newobject frida_control_service_options_new;
+%newobject frida_control_service_new;
+
+FK_DECLARE_UNREF(FridaEndpointParameters, fk_endpoint_parameters_unref)
+FK_DECLARE_UNREF(FridaControlServiceOptions, fk_control_service_options_unref)
+FK_DECLARE_UNREF(FridaControlService, fk_control_service_unref)
+
+// Portal Service
+typedef struct _FridaPortalService FridaPortalService;
+typedef struct _FkPortal FkPortal;
+
+extern FkPortal* fk_portal_new(
+    FridaEndpointParameters* cluster_params,
+    FridaEndpointParameters* control_params,
+    guint queue_capacity
+);
+extern void fk_portal_free(FkPortal* self);
+extern FridaPortalService* fk_portal_get_service(FkPortal* self);
+extern FkEventQueue* fk_portal_get_events(FkPortal* self);
+extern GBytes* fk_portal_enumerate_tags(FkPortal* self, guint connection_id);
+
+extern void frida_portal_service_start_sync(FridaPortalService* self, GCancellable* cancellable, GError** error);
+extern void frida_portal_service_stop_sync(FridaPortalService* self, GCancellable* cancellable, GError** error);
+extern void frida_portal_service_kick(FridaPortalService* self, guint connection_id);
+extern void frida_portal_service_post(FridaPortalService* self, guint connection_id, const gchar* json, GBytes* data);
+extern void frida_portal_service_narrowcast(FridaPortalService* self, const gchar* tag, const gchar* json, GBytes* data);
+extern void frida_portal_service_broadcast(FridaPortalService* self, const gchar* json, GBytes* data);
+extern void frida_portal_service_tag(FridaPortalService* self, guint connection_id, const gchar* tag);
+extern void frida_portal_service_untag(FridaPortalService* self, guint connection_id, const gchar* tag);
+
+%newobject fk_portal_new;
+%delobject fk_portal_free;
+
+// Spawning
+typedef struct _FridaSpawnOptions FridaSpawnOptions;
+typedef struct _FridaSpawnList FridaSpawnList;
+typedef struct _FridaSpawn FridaSpawn;
+
+extern guint frida_device_spawn_sync(
+    FridaDevice* self,
+    const gchar* program,
+    FridaSpawnOptions* options,
+    GCancellable* cancellable,
+    GError** error
+);
+extern void frida_device_resume_sync(FridaDevice* self, guint pid, GCancellable* cancellable, GError** error);
+extern void frida_device_kill_sync(FridaDevice* self, guint pid, GCancellable* cancellable, GError** error);
+extern void frida_device_enable_spawn_gating_sync(FridaDevice* self, GCancellable* cancellable, GError** error);
+extern void frida_device_disable_spawn_gating_sync(FridaDevice* self, GCancellable* cancellable, GError** error);
+
+extern FridaSpawnList* frida_device_enumerate_pending_spawn_sync(FridaDevice* self, GCancellable* cancellable, GError** error);
+extern gint frida_spawn_list_size(FridaSpawnList* self);
+extern FridaSpawn* frida_spawn_list_get(FridaSpawnList* self, gint index);
+extern guint frida_spawn_get_pid(FridaSpawn* self);
+extern const gchar* frida_spawn_get_identifier(FridaSpawn* self);
+
+%newobject frida_device_enumerate_pending_spawn_sync;
+%newobject frida_spawn_list_get;
+
+FK_DECLARE_UNREF(FridaSpawnList, fk_spawn_list_unref)
+FK_DECLARE_UNREF(FridaSpawn, fk_spawn_unref)
+
+// Agents
+typedef struct _FkAgent FkAgent;
+
+extern FkAgent* fk_agent_new(const gchar* name, const gchar* source, GBytes* bytes, guint queue_capacity);
+extern void fk_agent_free(FkAgent* self);
+extern FkEventQueue* fk_agent_get_events(FkAgent* self);
+extern void fk_agent_inject_sync(FkAgent* self, FridaDevice* device, guint pid, GError** error);
+extern void fk_agent_post(FkAgent* self, guint pid, const gchar* json, GBytes* data);
+extern GBytes* fk_agent_enumerate_pids(FkAgent* self);
+extern void fk_agent_reload(FkAgent* self, const gchar* source);
+
+%newobject fk_agent_new;
+%delobject fk_agent_free;
+
+// Spawn Pipeline
+typedef struct _FkSpawnPipeline FkSpawnPipeline;
+
+extern FkSpawnPipeline* fk_spawn_pipeline_new(FridaDevice* device, FkAgent* agent);
+extern void fk_spawn_pipeline_free(FkSpawnPipeline* self);
+extern void fk_spawn_pipeline_add_identifier(FkSpawnPipeline* self, const gchar* identifier);
+extern void fk_spawn_pipeline_start_sync(FkSpawnPipeline* self, GError** error);
+extern void fk_spawn_pipeline_stop_sync(FkSpawnPipeline* self, GError** error);
+extern FkEventQueue* fk_spawn_pipeline_get_events(FkSpawnPipeline* self);
+
+%newobject fk_spawn_pipeline_new;
+%delobject fk_spawn_pipeline_free;
+
+// Sessions and Child Gating
+typedef struct _FridaSession FridaSession;
+typedef struct _FridaSessionOptions FridaSessionOptions;
+typedef enum {
+    FRIDA_CHILD_ORIGIN_FORK,
+    FRIDA_CHILD_ORIGIN_EXEC,
+    FRIDA_CHILD_ORIGIN_SPAWN
+} FridaChildOrigin;
+
+extern FridaSession* frida_device_attach_sync(
+    FridaDevice* self,
+    guint pid,
+    FridaSessionOptions* options,
+    GCancellable* cancellable,
+    GError** error
+);
+extern guint frida_session_get_pid(FridaSession* self);
+extern gboolean frida_session_is_detached(FridaSession* self);
+extern void frida_session_detach_sync(FridaSession* self, GCancellable* cancellable, GError** error);
+extern void frida_session_enable_child_gating_sync(FridaSession* self, GCancellable* cancellable, GError** error);
+extern void frida_session_disable_child_gating_sync(FridaSession* self, GCancellable* cancellable, GError** error);
+
+extern GBytes* fk_device_enumerate_pending_children(FridaDevice* device, GError** error);
+
+%newobject frida_device_attach_sync;
+
+FK_DECLARE_UNREF(FridaSession, fk_session_unref)
+
+// Child Follower
+typedef struct _FkChildFollower FkChildFollower;
+
+extern FkChildFollower* fk_child_follower_new(FridaDevice* device, FkAgent* agent);
+extern void fk_child_follower_free(FkChildFollower* self);
+extern void fk_child_follower_start_sync(FkChildFollower* self, GError** error);
+extern void fk_child_follower_stop_sync(FkChildFollower* self);
+extern FkEventQueue* fk_child_follower_get_events(FkChildFollower* self);
+
+%newobject fk_child_follower_new;
+%delobject fk_child_follower_free;
+
+// Spawn Options
+typedef enum {
+    FRIDA_STDIO_INHERIT,
+    FRIDA_STDIO_PIPE
+} FridaStdio;
+
+extern FridaSpawnOptions* fk_spawn_options_new(gconstpointer buffer, gsize size, GError** error);
+
+%newobject fk_spawn_options_new;
+
+FK_DECLARE_UNREF(FridaSpawnOptions, fk_spawn_options_unref)
+
+// Process Stdio
+typedef struct _FkStdioCapture FkStdioCapture;
+
+typedef enum {
+    FK_STDIO_CAPTURE_STDOUT = 1 << 0,
+    FK_STDIO_CAPTURE_STDERR = 1 << 1
+} FkStdioCaptureStreams;
+
+typedef enum {
+    FK_STDIO_CAPTURE_ENDED = -1,
+    FK_STDIO_CAPTURE_LOST = -2
+} FkStdioCaptureStatus;
+
+extern FkStdioCapture* fk_stdio_capture_new(FridaDevice* device, guint capacity);
+extern void fk_stdio_capture_free(FkStdioCapture* self);
+extern void fk_stdio_capture_close(FkStdioCapture* self);
+extern void fk_stdio_capture_watch(FkStdioCapture* self, guint pid, gint streams);
+extern void fk_stdio_capture_unwatch(FkStdioCapture* self, guint pid);
+extern gint fk_stdio_capture_read(FkStdioCapture* self, guint pid, gint fd, gpointer buffer, gsize size, gint timeout_ms);
+extern gint64 fk_stdio_capture_skip_lost(FkStdioCapture* self, guint pid, gint fd);
+extern gint64 fk_stdio_capture_get_dropped(FkStdioCapture* self, guint pid, gint fd);
+extern void fk_stdio_capture_input(FkStdioCapture* self, guint pid, gconstpointer buffer, gsize size, GError** error);
+
+%newobject fk_stdio_capture_new;
+%delobject fk_stdio_capture_free;
+
+// Crash Collector
+typedef struct _FkCrashCollector FkCrashCollector;
+
+extern FkCrashCollector* fk_crash_collector_new(FkDeviceRegistry* registry, guint capacity);
+extern void fk_crash_collector_free(FkCrashCollector* self);
+extern FkEventQueue* fk_crash_collector_get_events(FkCrashCollector* self);
+extern GBytes* fk_crash_collector_get_report(FkCrashCollector* self, guint id);
+extern GBytes* fk_crash_collector_get_parameters(FkCrashCollector* self, guint id);
+extern void fk_crash_collector_forget(FkCrashCollector* self, guint id);
+
+%newobject fk_crash_collector_new;
+%delobject fk_crash_collector_free;
+
+// Library Injection
+typedef struct _FkInjection FkInjection;
+
+extern FkInjection* fk_injection_new_for_device(FridaDevice* device, guint capacity);
+extern FkInjection* fk_injection_new_local(gboolean inprocess, guint capacity);
+extern void fk_injection_free(FkInjection* self);
+extern guint fk_injection_add_blob(FkInjection* self, gconstpointer buffer, gsize size);
+extern guint fk_injection_add_blob_file(FkInjection* self, const gchar* path, GError** error);
+extern void fk_injection_release_blob(FkInjection* self, guint blob);
+extern guint fk_injection_get_blob_count(FkInjection* self);
+extern guint fk_injection_inject_blob_sync(FkInjection* self, guint pid, guint blob, const gchar* entrypoint, const gchar* data, GError** error);
+extern guint fk_injection_inject_file_sync(FkInjection* self, guint pid, const gchar* path, const gchar* entrypoint, const gchar* data, GError** error);
+extern void fk_injection_demonitor_sync(FkInjection* self, guint id, GError** error);
+extern void fk_injection_recreate_thread_sync(FkInjection* self, guint pid, guint id, GError** error);
+extern FkEventQueue* fk_injection_get_events(FkInjection* self);
+
+%newobject fk_injection_new_for_device;
+%newobject fk_injection_new_local;
+%delobject fk_injection_free;
+
+// Icons
+typedef struct _FkIcon FkIcon;
+typedef struct _FkIconCache FkIconCache;
+
+extern void fk_icon_unref(FkIcon* self);
+extern const gchar* fk_icon_get_format(FkIcon* self);
+extern gint fk_icon_get_width(FkIcon* self);
+extern gint fk_icon_get_height(FkIcon* self);
+extern FkDirectBuffer fk_icon_get_pixels(FkIcon* self);
+extern FkIcon* fk_icon_new_for_device(FridaDevice* device);
+
+extern FkIconCache* fk_icon_cache_new(guint capacity);
+extern void fk_icon_cache_free(FkIconCache* self);
+extern FkIcon* fk_icon_cache_get_application_icon(FkIconCache* self, FridaDevice* device, const gchar* identifier, gint width, GError** error);
+extern void fk_icon_cache_prefetch_applications(FkIconCache* self, FridaDevice* device, GError** error);
+extern void fk_icon_cache_clear(FkIconCache* self);
+
+%newobject fk_icon_new_for_device;
+%newobject fk_icon_cache_get_application_icon;
+%newobject fk_icon_cache_new;
+%delobject fk_icon_unref;
+%delobject fk_icon_cache_free;
+
+// Application Tracker
+typedef struct _FkAppTracker FkAppTracker;
+
+extern FkAppTracker* fk_app_tracker_new(FridaDevice* device, const gchar* keys);
+extern void fk_app_tracker_free(FkAppTracker* self);
+extern GBytes* fk_app_tracker_poll(FkAppTracker* self, GError** error);
+extern void fk_app_tracker_reset(FkAppTracker* self);
+
+%newobject fk_app_tracker_new;
+%delobject fk_app_tracker_free;
+
+// Device Bus
+typedef struct _FkBus FkBus;
+
+extern FkBus* fk_bus_new(FridaDevice* device, guint capacity, guint coalesce_ms);
+extern void fk_bus_free(FkBus* self);
+extern void fk_bus_attach_sync(FkBus* self, GError** error);
+extern void fk_bus_post(FkBus* self, const gchar* json, GBytes* data);
+extern gboolean fk_bus_is_detached(FkBus* self);
+extern FkEventQueue* fk_bus_get_events(FkBus* self);
+
+%newobject fk_bus_new;
+%delobject fk_bus_free;
+
+// Device Channels
+typedef struct _FkChannel FkChannel;
+
+typedef enum {
+    FK_CHANNEL_READABLE = 1 << 0,
+    FK_CHANNEL_WRITABLE = 1 << 1
+} FkChannelReadiness;
+
+extern FkChannel* fk_channel_open_sync(FridaDevice* device, const gchar* address, gboolean nonblocking, guint capacity, GError** error);
+extern void fk_channel_unref(FkChannel* self);
+extern void fk_channel_close(FkChannel* self);
+extern gint fk_channel_read(FkChannel* self, gpointer buffer, gsize size, GError** error);
+extern gint fk_channel_write(FkChannel* self, gconstpointer buffer, gsize size, GError** error);
+extern gint fk_channel_poll(FkChannel* self, gint interest, gint timeout_ms);
+
+%newobject fk_channel_open_sync;
+%delobject fk_channel_unref;
+
+// Port Forwarding
+typedef struct _FkForwarder FkForwarder;
+
+extern FkForwarder* fk_forwarder_new(FridaDevice* device, const gchar* remote_address, const gchar* address, guint16 port, GError** error);
+extern void fk_forwarder_free(FkForwarder* self);
+extern guint16 fk_forwarder_get_port(FkForwarder* self);
+extern GBytes* fk_forwarder_get_stats(FkForwarder* self);
+
+%newobject fk_forwarder_new;
+%delobject fk_forwarder_free;
+
+// Platform Services
+typedef struct _FkService FkService;
+
+extern FkService* fk_service_open_sync(FridaDevice* device, const gchar* address, GError** error);
+extern void fk_service_free(FkService* self);
+extern guint fk_service_request(FkService* self, gconstpointer buffer, gsize size, GError** error);
+extern gboolean fk_service_is_closed(FkService* self);
+extern FkEventQueue* fk_service_get_events(FkService* self);
+
+%newobject fk_service_open_sync;
+%delobject fk_service_free;
+
+// File Monitoring
+typedef struct _FkFileMonitor FkFileMonitor;
+
+extern FkFileMonitor* fk_file_monitor_new(const gchar* path, guint coalesce_ms, guint capacity);
+extern void fk_file_monitor_free(FkFileMonitor* self);
+extern void fk_file_monitor_enable_sync(FkFileMonitor* self, GError** error);
+extern void fk_file_monitor_disable_sync(FkFileMonitor* self, GError** error);
+extern FkEventQueue* fk_file_monitor_get_events(FkFileMonitor* self);
+
+%newobject fk_file_monitor_new;
+%delobject fk_file_monitor_free;
+
+// Hot Reload
+typedef struct _FkHotReload FkHotReload;
+
+extern FkHotReload* fk_hot_reload_new(FkDeviceRegistry* registry, FkAgent* agent, guint capacity);
+extern void fk_hot_reload_free(FkHotReload* self);
+extern void fk_hot_reload_watch_sync(FkHotReload* self, const gchar* entrypoint, const gchar* project_root, GError** error);
+extern FkEventQueue* fk_hot_reload_get_events(FkHotReload* self);
+
+%newobject fk_hot_reload_new;
+%delobject fk_hot_reload_free;
+
+// Peer Connections
+typedef struct _FridaPeerOptions FridaPeerOptions;
+
+typedef enum {
+    FRIDA_RELAY_KIND_TURN_UDP,
+    FRIDA_RELAY_KIND_TURN_TCP,
+    FRIDA_RELAY_KIND_TURN_TLS
+} FridaRelayKind;
+
+typedef enum {
+    FK_SESSION_TRANSPORT_CONTROL,
+    FK_SESSION_TRANSPORT_PEER,
+    FK_SESSION_TRANSPORT_DETACHED
+} FkSessionTransport;
+
+extern FridaPeerOptions* fk_peer_options_new(const gchar* stun_server);
+extern void fk_peer_options_add_relay(FridaPeerOptions* options, const gchar* address, const gchar* username, const gchar* password, FridaRelayKind kind);
+extern void fk_session_setup_peer_connection_sync(FridaSession* session, FridaPeerOptions* options, GError** error);
+extern FkSessionTransport fk_session_get_transport(FridaSession* session);
+extern void fk_agent_set_peer_options(FkAgent* self, FridaPeerOptions* options);
+
+%newobject fk_peer_options_new;
+
+FK_DECLARE_UNREF(FridaPeerOptions, fk_peer_options_unref)
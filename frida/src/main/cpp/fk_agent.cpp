@@ -0,0 +1,795 @@
+#include "fk_agent.h"
+#include "fk_main_context.h"
+#include "fk_session.h"
+#include "fk_writer.h"
+
+struct FkAgentInstance {
+    FkAgent *agent;
+    FridaDevice *device;
+    guint pid;
+    FridaSession *session;
+    FridaScript *script;
+    gulong message_handler;
+    gulong detached_handler;
+    guint generation;
+    gboolean swapping;
+};
+
+struct _FkAgent {
+    volatile gint ref_count;
+    gchar *name;
+    gchar *source;
+    GBytes *bytes;
+    GHashTable *compiled;
+    FkEventQueue *events;
+    GPtrArray *instances;
+    GHashTable *gated_devices;
+    gboolean closed;
+    guint generation;
+    FridaPeerOptions *peer_options;
+};
+
+struct FkAgentLoad {
+    FkAgent *agent;
+    FridaDevice *device;
+    guint pid;
+    FridaSession *session;
+    guint generation;
+    gboolean from_bytes;
+    FkAgentLoadCallback callback;
+    gpointer user_data;
+};
+
+// A script being swapped into (or retired from) the session loaded into pid.
+// While it is not the instance's script, its messages are forwarded through
+// here, so nothing it sends during load or unload is lost.
+struct FkAgentSwap {
+    FkAgent *agent;
+    FridaDevice *device;
+    guint pid;
+    FridaSession *session;
+    FridaScript *script;
+    gulong message_handler;
+    guint generation;
+    gboolean from_bytes;
+};
+
+static void fk_agent_instance_refresh(FkAgentInstance *instance);
+static void fk_agent_create_script(FkAgentLoad *load);
+
+static void fk_agent_publish(FkAgent *self, FkWriter &writer) {
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_agent_instance_free(gpointer data) {
+    FkAgentInstance *instance = (FkAgentInstance *) data;
+    g_signal_handler_disconnect(instance->script, instance->message_handler);
+    g_signal_handler_disconnect(instance->session, instance->detached_handler);
+    g_object_unref(instance->script);
+    g_object_unref(instance->session);
+    g_object_unref(instance->device);
+    g_free(instance);
+}
+
+static void fk_agent_on_message(FridaScript *script, const gchar *json, GBytes *data, gpointer user_data) {
+    FkAgentInstance *instance = (FkAgentInstance *) user_data;
+    FkWriter writer;
+    writer.put_u8(FK_AGENT_MESSAGE);
+    writer.put_u32(instance->pid);
+    writer.put_string(json);
+    writer.put_gbytes(data);
+    fk_agent_publish(instance->agent, writer);
+}
+
+static void fk_agent_on_detached(FridaSession *session, FridaSessionDetachReason reason, FridaCrash *crash,
+                                 gpointer user_data) {
+    FkAgentInstance *instance = (FkAgentInstance *) user_data;
+    FkAgent *self = instance->agent;
+
+    FkWriter writer;
+    writer.put_u8(FK_AGENT_DETACHED);
+    writer.put_u32(instance->pid);
+    writer.put_u32((guint32) reason);
+    fk_agent_publish(self, writer);
+
+    g_ptr_array_remove(self->instances, instance);
+}
+
+static void fk_agent_load_finish(FkAgentLoad *load, FridaScript *script, GError *error) {
+    FkAgent *self = load->agent;
+
+    if (script != NULL && self->closed) {
+        frida_script_unload(script, NULL, NULL, NULL);
+        frida_session_detach(load->session, NULL, NULL, NULL);
+    } else if (script != NULL) {
+        FkAgentInstance *instance = g_new0(FkAgentInstance, 1);
+        instance->agent = self;
+        instance->device = (FridaDevice *) g_object_ref(load->device);
+        instance->pid = load->pid;
+        instance->session = (FridaSession *) g_object_ref(load->session);
+        instance->script = (FridaScript *) g_object_ref(script);
+        instance->message_handler =
+            g_signal_connect(script, "message", G_CALLBACK(fk_agent_on_message), instance);
+        instance->detached_handler =
+            g_signal_connect(load->session, "detached", G_CALLBACK(fk_agent_on_detached), instance);
+        instance->generation = load->generation;
+        g_ptr_array_add(self->instances, instance);
+
+        FkWriter writer;
+        writer.put_u8(FK_AGENT_LOADED);
+        writer.put_u32(load->pid);
+        writer.put_u8(fk_session_get_transport(load->session));
+        fk_agent_publish(self, writer);
+
+        // Reloaded while this load was in flight.
+        fk_agent_instance_refresh(instance);
+    } else if (load->session != NULL) {
+        frida_session_detach(load->session, NULL, NULL, NULL);
+    }
+
+    if (load->callback != NULL)
+        load->callback(self, load->pid, error, load->user_data);
+
+    if (script != NULL)
+        g_object_unref(script);
+    if (load->session != NULL)
+        g_object_unref(load->session);
+    g_object_unref(load->device);
+    fk_agent_unref(self);
+    g_free(load);
+}
+
+static void fk_agent_on_script_loaded(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentLoad *load = (FkAgentLoad *) user_data;
+    FridaScript *script = (FridaScript *) source;
+    GError *error = NULL;
+
+    frida_script_load_finish(script, result, &error);
+    if (error != NULL)
+        frida_script_unload(script, NULL, NULL, NULL);
+    fk_agent_load_finish(load, error == NULL ? (FridaScript *) g_object_ref(script) : NULL, error);
+    g_clear_error(&error);
+}
+
+static void fk_agent_bytes_free(gpointer data) {
+    if (data != NULL)
+        g_bytes_unref((GBytes *) data);
+}
+
+// Bytecode to create scripts from on device: what the agent was built from,
+// or what this source compiled to there. NULL means create from source.
+static GBytes *fk_agent_lookup_bytes(FkAgent *self, FridaDevice *device) {
+    if (self->source == NULL)
+        return self->bytes;
+    return (GBytes *) g_hash_table_lookup(self->compiled, device);
+}
+
+// Records bytecode compiled on device, or NULL when it can't be used there,
+// unless that device already has an entry.
+static void fk_agent_remember_bytes(FkAgent *self, FridaDevice *device, GBytes *bytes) {
+    if (g_hash_table_contains(self->compiled, device))
+        return;
+    g_hash_table_insert(self->compiled, g_object_ref(device), bytes != NULL ? g_bytes_ref(bytes) : NULL);
+}
+
+// The device rejected its bytecode (say, a different runtime version); it
+// is created from source from now on.
+static void fk_agent_forget_bytes(FkAgent *self, FridaDevice *device) {
+    g_hash_table_replace(self->compiled, g_object_ref(device), NULL);
+}
+
+static void fk_agent_on_script_created(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentLoad *load = (FkAgentLoad *) user_data;
+    GError *error = NULL;
+
+    FridaScript *script = load->from_bytes
+                              ? frida_session_create_script_from_bytes_finish(load->session, result, &error)
+                              : frida_session_create_script_finish(load->session, result, &error);
+    if (script == NULL && load->from_bytes && load->agent->source != NULL) {
+        g_error_free(error);
+        fk_agent_forget_bytes(load->agent, load->device);
+        fk_agent_create_script(load);
+        return;
+    }
+    if (script == NULL) {
+        fk_agent_load_finish(load, NULL, error);
+        g_error_free(error);
+        return;
+    }
+
+    frida_script_load(script, NULL, fk_agent_on_script_loaded, load);
+    g_object_unref(script);
+}
+
+static FridaScriptOptions *fk_agent_script_options(FkAgent *self) {
+    FridaScriptOptions *options = frida_script_options_new();
+    if (self->name != NULL)
+        frida_script_options_set_name(options, self->name);
+    return options;
+}
+
+static void fk_agent_create_script(FkAgentLoad *load) {
+    FkAgent *self = load->agent;
+    FridaScriptOptions *options = fk_agent_script_options(self);
+
+    GBytes *bytes = fk_agent_lookup_bytes(self, load->device);
+    load->generation = self->generation;
+    load->from_bytes = bytes != NULL;
+    if (load->from_bytes)
+        frida_session_create_script_from_bytes(load->session, bytes, options, NULL, fk_agent_on_script_created, load);
+    else
+        frida_session_create_script(load->session, self->source, options, NULL, fk_agent_on_script_created, load);
+
+    g_object_unref(options);
+}
+
+// The first load of a source agent on a device compiles it once; every later
+// load there (every child, every spawn) creates its script from the cached
+// bytecode. Bytecode is kept per device, as devices may run different
+// runtimes; one that can't compile falls back to source for good.
+static void fk_agent_on_compiled(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentLoad *load = (FkAgentLoad *) user_data;
+    FkAgent *self = load->agent;
+    GError *error = NULL;
+
+    GBytes *bytes = frida_session_compile_script_finish(load->session, result, &error);
+    // A source that has since been reloaded is dropped; the load creates
+    // from the current one instead.
+    if (load->generation == self->generation)
+        fk_agent_remember_bytes(self, load->device, bytes);
+    if (bytes != NULL)
+        g_bytes_unref(bytes);
+    g_clear_error(&error);
+
+    fk_agent_create_script(load);
+}
+
+static void fk_agent_prepare_script(FkAgentLoad *load) {
+    FkAgent *self = load->agent;
+
+    if (self->source != NULL && !g_hash_table_contains(self->compiled, load->device)) {
+        load->generation = self->generation;
+        FridaScriptOptions *options = fk_agent_script_options(self);
+        frida_session_compile_script(load->session, self->source, options, NULL, fk_agent_on_compiled, load);
+        g_object_unref(options);
+        return;
+    }
+
+    fk_agent_create_script(load);
+}
+
+static void fk_agent_on_child_gating_enabled(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentLoad *load = (FkAgentLoad *) user_data;
+    GError *error = NULL;
+
+    frida_session_enable_child_gating_finish((FridaSession *) source, result, &error);
+    if (error != NULL) {
+        fk_agent_load_finish(load, NULL, error);
+        g_error_free(error);
+        return;
+    }
+
+    fk_agent_prepare_script(load);
+}
+
+static void fk_agent_configure_session(FkAgentLoad *load) {
+    if (g_hash_table_contains(load->agent->gated_devices, load->device))
+        frida_session_enable_child_gating(load->session, NULL, fk_agent_on_child_gating_enabled, load);
+    else
+        fk_agent_prepare_script(load);
+}
+
+// A session whose peer connection can't be set up stays on the control
+// channel; LOADED reports which transport it ended up with.
+static void fk_agent_on_peer_connection_ready(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentLoad *load = (FkAgentLoad *) user_data;
+    fk_session_setup_peer_connection_finish(load->session, result, NULL);
+    fk_agent_configure_session(load);
+}
+
+static void fk_agent_on_attached(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentLoad *load = (FkAgentLoad *) user_data;
+    GError *error = NULL;
+
+    load->session = frida_device_attach_finish((FridaDevice *) source, result, &error);
+    if (load->session == NULL) {
+        fk_agent_load_finish(load, NULL, error);
+        g_error_free(error);
+        return;
+    }
+
+    if (load->agent->peer_options != NULL)
+        frida_session_setup_peer_connection(load->session, load->agent->peer_options, NULL,
+                                            fk_agent_on_peer_connection_ready, load);
+    else
+        fk_agent_configure_session(load);
+}
+
+FkAgent *fk_agent_new(const gchar *name, const gchar *source, GBytes *bytes, guint queue_capacity) {
+    FkAgent *self = g_new0(FkAgent, 1);
+    self->ref_count = 1;
+    self->name = g_strdup(name);
+    self->source = g_strdup(source);
+    self->bytes = bytes != NULL ? g_bytes_ref(bytes) : NULL;
+    self->compiled = g_hash_table_new_full(NULL, NULL, g_object_unref, fk_agent_bytes_free);
+    self->events = fk_event_queue_new(queue_capacity);
+    self->instances = g_ptr_array_new_with_free_func(fk_agent_instance_free);
+    self->gated_devices = g_hash_table_new_full(NULL, NULL, g_object_unref, NULL);
+    return self;
+}
+
+static void fk_agent_close(gpointer user_data) {
+    FkAgent *self = (FkAgent *) user_data;
+
+    self->closed = TRUE;
+    for (guint i = 0; i != self->instances->len; i++) {
+        FkAgentInstance *instance = (FkAgentInstance *) g_ptr_array_index(self->instances, i);
+        frida_script_unload(instance->script, NULL, NULL, NULL);
+        frida_session_detach(instance->session, NULL, NULL, NULL);
+    }
+    g_ptr_array_set_size(self->instances, 0);
+}
+
+// Unloads every instance and drops the caller's reference; loads still in
+// flight keep the agent alive until they complete and clean up after
+// themselves.
+void fk_agent_free(FkAgent *self) {
+    if (self == NULL)
+        return;
+    fk_invoke_sync(fk_agent_close, self);
+    fk_event_queue_close(self->events);
+    fk_agent_unref(self);
+}
+
+FkAgent *fk_agent_ref(FkAgent *self) {
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+void fk_agent_unref(FkAgent *self) {
+    if (!g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+    g_ptr_array_unref(self->instances);
+    g_hash_table_unref(self->gated_devices);
+    g_hash_table_unref(self->compiled);
+    fk_event_queue_free(self->events);
+    if (self->peer_options != NULL)
+        g_object_unref(self->peer_options);
+    if (self->bytes != NULL)
+        g_bytes_unref(self->bytes);
+    g_free(self->source);
+    g_free(self->name);
+    g_free(self);
+}
+
+FkEventQueue *fk_agent_get_events(FkAgent *self) {
+    return self->events;
+}
+
+// Attaches to pid and loads the agent; must be called on the frida main
+// context. The callback, if any, runs there too once the script is live.
+void fk_agent_load(FkAgent *self, FridaDevice *device, guint pid, FkAgentLoadCallback callback, gpointer user_data) {
+    FkAgentLoad *load = g_new0(FkAgentLoad, 1);
+    load->agent = fk_agent_ref(self);
+    load->device = (FridaDevice *) g_object_ref(device);
+    load->pid = pid;
+    load->callback = callback;
+    load->user_data = user_data;
+
+    if (self->closed) {
+        GError *error = g_error_new_literal(FRIDA_ERROR, FRIDA_ERROR_INVALID_OPERATION, "Agent is closed");
+        fk_agent_load_finish(load, NULL, error);
+        g_error_free(error);
+        return;
+    }
+
+    frida_device_attach(device, pid, NULL, NULL, fk_agent_on_attached, load);
+}
+
+static void fk_agent_apply_child_gating(FkAgent *self, FridaDevice *device, gboolean enabled) {
+    for (guint i = 0; i != self->instances->len; i++) {
+        FkAgentInstance *instance = (FkAgentInstance *) g_ptr_array_index(self->instances, i);
+        if (instance->device != device)
+            continue;
+        if (enabled)
+            frida_session_enable_child_gating(instance->session, NULL, NULL, NULL);
+        else
+            frida_session_disable_child_gating(instance->session, NULL, NULL, NULL);
+    }
+}
+
+// Main context only. Child gating is counted per device: the first acquire
+// gates every live instance on that device and every session created there
+// from now on, the last release ungates them, so several followers can share
+// an agent and sessions on other devices are never touched.
+void fk_agent_acquire_child_gating(FkAgent *self, FridaDevice *device) {
+    guint count = GPOINTER_TO_UINT(g_hash_table_lookup(self->gated_devices, device));
+    if (count == 0)
+        g_object_ref(device);
+    g_hash_table_insert(self->gated_devices, device, GUINT_TO_POINTER(count + 1));
+    if (count == 0)
+        fk_agent_apply_child_gating(self, device, TRUE);
+}
+
+void fk_agent_release_child_gating(FkAgent *self, FridaDevice *device) {
+    guint count = GPOINTER_TO_UINT(g_hash_table_lookup(self->gated_devices, device));
+    if (count == 0)
+        return;
+    if (count > 1) {
+        g_hash_table_insert(self->gated_devices, device, GUINT_TO_POINTER(count - 1));
+        return;
+    }
+    fk_agent_apply_child_gating(self, device, FALSE);
+    g_hash_table_remove(self->gated_devices, device);
+}
+
+struct FkAgentPeerOptions {
+    FkAgent *agent;
+    FridaPeerOptions *options;
+};
+
+static void fk_agent_do_set_peer_options(gpointer user_data) {
+    FkAgentPeerOptions *update = (FkAgentPeerOptions *) user_data;
+    FkAgent *self = update->agent;
+    if (self->peer_options != NULL)
+        g_object_unref(self->peer_options);
+    self->peer_options = update->options != NULL ? (FridaPeerOptions *) g_object_ref(update->options) : NULL;
+}
+
+// Sessions attached from now on are upgraded to a peer connection before the
+// script is created, so script traffic skips the frida-server hop. NULL
+// reverts to the control channel; live instances are left as they are.
+void fk_agent_set_peer_options(FkAgent *self, FridaPeerOptions *options) {
+    FkAgentPeerOptions update = { self, options };
+    fk_invoke_sync(fk_agent_do_set_peer_options, &update);
+}
+
+static FkAgentInstance *fk_agent_find_instance_for_pid(FkAgent *self, FridaDevice *device, guint pid) {
+    for (guint i = 0; i != self->instances->len; i++) {
+        FkAgentInstance *instance = (FkAgentInstance *) g_ptr_array_index(self->instances, i);
+        if (instance->pid == pid && instance->device == device)
+            return instance;
+    }
+    return NULL;
+}
+
+// Main context only.
+gboolean fk_agent_is_loaded_into(FkAgent *self, FridaDevice *device, guint pid) {
+    return fk_agent_find_instance_for_pid(self, device, pid) != NULL;
+}
+
+// Main context only. Unowned; NULL when not loaded into pid.
+FridaSession *fk_agent_get_session(FkAgent *self, FridaDevice *device, guint pid) {
+    FkAgentInstance *instance = fk_agent_find_instance_for_pid(self, device, pid);
+    return instance != NULL ? instance->session : NULL;
+}
+
+struct FkAgentInjection {
+    FkAgent *agent;
+    FridaDevice *device;
+    guint pid;
+    GMutex lock;
+    GCond cond;
+    gboolean done;
+    GError *error;
+};
+
+static void fk_agent_on_injected(FkAgent *agent, guint pid, const GError *error, gpointer user_data) {
+    FkAgentInjection *injection = (FkAgentInjection *) user_data;
+
+    g_mutex_lock(&injection->lock);
+    injection->error = error != NULL ? g_error_copy(error) : NULL;
+    injection->done = TRUE;
+    g_cond_signal(&injection->cond);
+    g_mutex_unlock(&injection->lock);
+}
+
+static void fk_agent_begin_injection(gpointer user_data) {
+    FkAgentInjection *injection = (FkAgentInjection *) user_data;
+    fk_agent_load(injection->agent, injection->device, injection->pid, fk_agent_on_injected, injection);
+}
+
+void fk_agent_inject_sync(FkAgent *self, FridaDevice *device, guint pid, GError **error) {
+    FkAgentInjection injection;
+    injection.agent = self;
+    injection.device = device;
+    injection.pid = pid;
+    g_mutex_init(&injection.lock);
+    g_cond_init(&injection.cond);
+    injection.done = FALSE;
+    injection.error = NULL;
+
+    fk_invoke_sync(fk_agent_begin_injection, &injection);
+
+    g_mutex_lock(&injection.lock);
+    while (!injection.done)
+        g_cond_wait(&injection.cond, &injection.lock);
+    g_mutex_unlock(&injection.lock);
+
+    if (injection.error != NULL)
+        g_propagate_error(error, injection.error);
+
+    g_cond_clear(&injection.cond);
+    g_mutex_clear(&injection.lock);
+}
+
+struct FkAgentPost {
+    FkAgent *agent;
+    guint pid;
+    const gchar *json;
+    GBytes *data;
+};
+
+static void fk_agent_do_post(gpointer user_data) {
+    FkAgentPost *post = (FkAgentPost *) user_data;
+    GPtrArray *instances = post->agent->instances;
+
+    for (guint i = 0; i != instances->len; i++) {
+        FkAgentInstance *instance = (FkAgentInstance *) g_ptr_array_index(instances, i);
+        if (post->pid == 0 || instance->pid == post->pid)
+            frida_script_post(instance->script, post->json, post->data);
+    }
+}
+
+// Posts to the instance loaded into pid, or to every instance when pid is 0.
+void fk_agent_post(FkAgent *self, guint pid, const gchar *json, GBytes *data) {
+    FkAgentPost post = { self, pid, json, data };
+    fk_invoke_sync(fk_agent_do_post, &post);
+}
+
+struct FkAgentPids {
+    FkAgent *agent;
+    FkWriter *writer;
+};
+
+static void fk_agent_collect_pids(gpointer user_data) {
+    FkAgentPids *pids = (FkAgentPids *) user_data;
+    GPtrArray *instances = pids->agent->instances;
+
+    pids->writer->put_u32(instances->len);
+    for (guint i = 0; i != instances->len; i++) {
+        FkAgentInstance *instance = (FkAgentInstance *) g_ptr_array_index(instances, i);
+        pids->writer->put_u32(instance->pid);
+        pids->writer->put_u8(fk_session_get_transport(instance->session));
+    }
+}
+
+// u32 count, count x (u32 pid, u8 FkSessionTransport)
+GBytes *fk_agent_enumerate_pids(FkAgent *self) {
+    FkWriter writer;
+    FkAgentPids pids = { self, &writer };
+    fk_invoke_sync(fk_agent_collect_pids, &pids);
+    return writer.steal();
+}
+
+static FkAgentInstance *fk_agent_find_instance(FkAgent *self, FridaSession *session) {
+    for (guint i = 0; i != self->instances->len; i++) {
+        FkAgentInstance *instance = (FkAgentInstance *) g_ptr_array_index(self->instances, i);
+        if (instance->session == session)
+            return instance;
+    }
+    return NULL;
+}
+
+static void fk_agent_on_swap_message(FridaScript *script, const gchar *json, GBytes *data, gpointer user_data) {
+    FkAgentSwap *swap = (FkAgentSwap *) user_data;
+    FkWriter writer;
+    writer.put_u8(FK_AGENT_MESSAGE);
+    writer.put_u32(swap->pid);
+    writer.put_string(json);
+    writer.put_gbytes(data);
+    fk_agent_publish(swap->agent, writer);
+}
+
+static void fk_agent_swap_free(FkAgentSwap *swap) {
+    if (swap->script != NULL) {
+        if (swap->message_handler != 0)
+            g_signal_handler_disconnect(swap->script, swap->message_handler);
+        g_object_unref(swap->script);
+    }
+    g_object_unref(swap->session);
+    g_object_unref(swap->device);
+    fk_agent_unref(swap->agent);
+    g_free(swap);
+}
+
+static void fk_agent_on_retired(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentSwap *swap = (FkAgentSwap *) user_data;
+    frida_script_unload_finish((FridaScript *) source, result, NULL);
+    fk_agent_swap_free(swap);
+}
+
+// Ends a swap, successful or not, and starts the next one if the agent was
+// reloaded again meanwhile; swaps of one instance never overlap.
+static void fk_agent_swap_finish(FkAgentSwap *swap, const GError *error) {
+    FkAgent *self = swap->agent;
+    FkAgentInstance *instance = fk_agent_find_instance(self, swap->session);
+
+    // A script that was created but failed to load is still in the target.
+    if (swap->script != NULL && (error != NULL || instance == NULL || self->closed))
+        frida_script_unload(swap->script, NULL, NULL, NULL);
+
+    if (instance == NULL || self->closed) {
+        fk_agent_swap_free(swap);
+        return;
+    }
+
+    FkWriter writer;
+    if (error == NULL) {
+        // Hand the new script over to the instance before the old one stops:
+        // the swap forwards whatever the old script sends while it unloads.
+        FridaScript *retired = instance->script;
+        g_signal_handler_disconnect(retired, instance->message_handler);
+        g_signal_handler_disconnect(swap->script, swap->message_handler);
+
+        instance->script = swap->script;
+        instance->message_handler =
+            g_signal_connect(instance->script, "message", G_CALLBACK(fk_agent_on_message), instance);
+
+        swap->script = retired;
+        swap->message_handler = g_signal_connect(retired, "message", G_CALLBACK(fk_agent_on_swap_message), swap);
+
+        writer.put_u8(FK_AGENT_RELOADED);
+        writer.put_u32(instance->pid);
+    } else {
+        writer.put_u8(FK_AGENT_RELOAD_FAILED);
+        writer.put_u32(instance->pid);
+        writer.put_string(error->message);
+    }
+    fk_agent_publish(self, writer);
+
+    instance->generation = swap->generation;
+    instance->swapping = FALSE;
+
+    if (error == NULL)
+        frida_script_unload(swap->script, NULL, fk_agent_on_retired, swap);
+    else
+        fk_agent_swap_free(swap);
+
+    fk_agent_instance_refresh(instance);
+}
+
+static void fk_agent_on_swap_loaded(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentSwap *swap = (FkAgentSwap *) user_data;
+    GError *error = NULL;
+
+    frida_script_load_finish((FridaScript *) source, result, &error);
+    fk_agent_swap_finish(swap, error);
+    g_clear_error(&error);
+}
+
+static void fk_agent_on_swap_created(GObject *source, GAsyncResult *result, gpointer user_data);
+
+static void fk_agent_swap_create(FkAgentSwap *swap) {
+    FkAgent *self = swap->agent;
+    FridaScriptOptions *options = fk_agent_script_options(self);
+
+    GBytes *bytes = fk_agent_lookup_bytes(self, swap->device);
+    swap->generation = self->generation;
+    swap->from_bytes = bytes != NULL;
+    if (swap->from_bytes)
+        frida_session_create_script_from_bytes(swap->session, bytes, options, NULL, fk_agent_on_swap_created, swap);
+    else
+        frida_session_create_script(swap->session, self->source, options, NULL, fk_agent_on_swap_created, swap);
+
+    g_object_unref(options);
+}
+
+static void fk_agent_on_swap_created(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentSwap *swap = (FkAgentSwap *) user_data;
+    FkAgent *self = swap->agent;
+    GError *error = NULL;
+
+    FridaScript *script = swap->from_bytes
+                              ? frida_session_create_script_from_bytes_finish(swap->session, result, &error)
+                              : frida_session_create_script_finish(swap->session, result, &error);
+    if (script == NULL && swap->from_bytes && self->source != NULL && !self->closed) {
+        g_error_free(error);
+        fk_agent_forget_bytes(self, swap->device);
+        fk_agent_swap_create(swap);
+        return;
+    }
+    if (script == NULL) {
+        fk_agent_swap_finish(swap, error);
+        g_error_free(error);
+        return;
+    }
+
+    swap->script = script;
+    swap->message_handler = g_signal_connect(script, "message", G_CALLBACK(fk_agent_on_swap_message), swap);
+    frida_script_load(script, NULL, fk_agent_on_swap_loaded, swap);
+}
+
+// Brings an instance up to the agent's current generation unless a swap is
+// already running for it.
+static void fk_agent_instance_refresh(FkAgentInstance *instance) {
+    FkAgent *self = instance->agent;
+    if (instance->swapping || instance->generation == self->generation || self->closed)
+        return;
+    instance->swapping = TRUE;
+
+    FkAgentSwap *swap = g_new0(FkAgentSwap, 1);
+    swap->agent = fk_agent_ref(self);
+    swap->device = (FridaDevice *) g_object_ref(instance->device);
+    swap->pid = instance->pid;
+    swap->session = (FridaSession *) g_object_ref(instance->session);
+    fk_agent_swap_create(swap);
+}
+
+static void fk_agent_refresh_instances(FkAgent *self) {
+    for (guint i = 0; i != self->instances->len; i++)
+        fk_agent_instance_refresh((FkAgentInstance *) g_ptr_array_index(self->instances, i));
+}
+
+struct FkAgentReload {
+    FkAgent *agent;
+    FridaDevice *device;
+    guint generation;
+};
+
+// The new source is compiled once, in the first live session; instances on
+// that device are then recreated from the cached bytes, the rest from source.
+static void fk_agent_on_reload_compiled(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkAgentReload *reload = (FkAgentReload *) user_data;
+    FkAgent *self = reload->agent;
+    GError *error = NULL;
+
+    GBytes *bytes = frida_session_compile_script_finish((FridaSession *) source, result, &error);
+    if (reload->generation == self->generation) {
+        fk_agent_remember_bytes(self, reload->device, bytes);
+        fk_agent_refresh_instances(self);
+    }
+    if (bytes != NULL)
+        g_bytes_unref(bytes);
+    g_clear_error(&error);
+
+    g_object_unref(reload->device);
+    fk_agent_unref(self);
+    g_free(reload);
+}
+
+// Main context only.
+void fk_agent_replace_source(FkAgent *self, const gchar *source) {
+    if (self->closed)
+        return;
+
+    g_free(self->source);
+    self->source = g_strdup(source);
+    if (self->bytes != NULL) {
+        g_bytes_unref(self->bytes);
+        self->bytes = NULL;
+    }
+    g_hash_table_remove_all(self->compiled);
+    self->generation++;
+
+    if (self->instances->len == 0)
+        return;
+
+    FkAgentInstance *first = (FkAgentInstance *) g_ptr_array_index(self->instances, 0);
+    FkAgentReload *reload = g_new0(FkAgentReload, 1);
+    reload->agent = fk_agent_ref(self);
+    reload->device = (FridaDevice *) g_object_ref(first->device);
+    reload->generation = self->generation;
+
+    FridaScriptOptions *options = fk_agent_script_options(self);
+    frida_session_compile_script(first->session, self->source, options, NULL, fk_agent_on_reload_compiled, reload);
+    g_object_unref(options);
+}
+
+struct FkAgentSource {
+    FkAgent *agent;
+    const gchar *source;
+};
+
+static void fk_agent_do_reload(gpointer user_data) {
+    FkAgentSource *reload = (FkAgentSource *) user_data;
+    fk_agent_replace_source(reload->agent, reload->source);
+}
+
+// Replaces the script in every live session without detaching. Each instance
+// loads its new script before the old one is unloaded, and both keep
+// publishing until then, so no message is lost across the swap.
+void fk_agent_reload(FkAgent *self, const gchar *source) {
+    FkAgentSource reload = { self, source };
+    fk_invoke_sync(fk_agent_do_reload, &reload);
+}
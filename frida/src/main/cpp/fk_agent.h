@@ -0,0 +1,52 @@
+#ifndef __FK_AGENT_H__
+#define __FK_AGENT_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// A script kept natively (as source or compiled bytes) together with every
+// session it is currently loaded into. Loading runs entirely on the frida main
+// context: attach, create script, load, with no JVM round trip in between.
+// Messages and lifecycle changes from all instances share one event queue:
+//   u8 FkAgentEvent, u32 pid, then
+//   MESSAGE:  string json, blob data
+//   LOADED:   u8 FkSessionTransport
+//   DETACHED: u32 FridaSessionDetachReason
+//   RELOADED: (nothing)
+//   RELOAD_FAILED: string error
+typedef struct _FkAgent FkAgent;
+
+typedef enum {
+    FK_AGENT_MESSAGE,
+    FK_AGENT_LOADED,
+    FK_AGENT_DETACHED,
+    FK_AGENT_RELOADED,
+    FK_AGENT_RELOAD_FAILED
+} FkAgentEvent;
+
+typedef void (*FkAgentLoadCallback)(FkAgent *agent, guint pid, const GError *error, gpointer user_data);
+
+FkAgent *fk_agent_new(const gchar *name, const gchar *source, GBytes *bytes, guint queue_capacity);
+void fk_agent_free(FkAgent *self);
+FkAgent *fk_agent_ref(FkAgent *self);
+void fk_agent_unref(FkAgent *self);
+
+FkEventQueue *fk_agent_get_events(FkAgent *self);
+
+void fk_agent_load(FkAgent *self, FridaDevice *device, guint pid, FkAgentLoadCallback callback, gpointer user_data);
+void fk_agent_inject_sync(FkAgent *self, FridaDevice *device, guint pid, GError **error);
+void fk_agent_acquire_child_gating(FkAgent *self, FridaDevice *device);
+void fk_agent_release_child_gating(FkAgent *self, FridaDevice *device);
+void fk_agent_set_peer_options(FkAgent *self, FridaPeerOptions *options);
+gboolean fk_agent_is_loaded_into(FkAgent *self, FridaDevice *device, guint pid);
+FridaSession *fk_agent_get_session(FkAgent *self, FridaDevice *device, guint pid);
+void fk_agent_post(FkAgent *self, guint pid, const gchar *json, GBytes *data);
+GBytes *fk_agent_enumerate_pids(FkAgent *self);
+void fk_agent_reload(FkAgent *self, const gchar *source);
+void fk_agent_replace_source(FkAgent *self, const gchar *source);
+
+G_END_DECLS
+
+#endif
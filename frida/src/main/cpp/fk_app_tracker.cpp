@@ -0,0 +1,184 @@
+#include "fk_app_tracker.h"
+#include "fk_marshal.h"
+
+struct FkAppState {
+    gchar *name;
+    guint pid;
+};
+
+struct _FkAppTracker {
+    FridaDevice *device;
+    gchar **keys;
+    GMutex lock;
+    GHashTable *known;
+};
+
+static void fk_app_state_free(gpointer data) {
+    FkAppState *state = (FkAppState *) data;
+    g_free(state->name);
+    g_free(state);
+}
+
+FkAppTracker *fk_app_tracker_new(FridaDevice *device, const gchar *keys) {
+    FkAppTracker *self = g_new0(FkAppTracker, 1);
+    self->device = (FridaDevice *) g_object_ref(device);
+    self->keys = keys != NULL ? g_strsplit(keys, ",", -1) : NULL;
+    g_mutex_init(&self->lock);
+    self->known = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, fk_app_state_free);
+    return self;
+}
+
+void fk_app_tracker_free(FkAppTracker *self) {
+    if (self == NULL)
+        return;
+    g_hash_table_unref(self->known);
+    g_mutex_clear(&self->lock);
+    g_strfreev(self->keys);
+    g_object_unref(self->device);
+    g_free(self);
+}
+
+void fk_app_tracker_reset(FkAppTracker *self) {
+    g_mutex_lock(&self->lock);
+    g_hash_table_remove_all(self->known);
+    g_mutex_unlock(&self->lock);
+}
+
+static FridaApplicationList *fk_app_tracker_query(FkAppTracker *self, FridaScope scope, GPtrArray *selection,
+                                                  GError **error) {
+    FridaApplicationQueryOptions *options = frida_application_query_options_new();
+    frida_application_query_options_set_scope(options, scope);
+    if (selection != NULL) {
+        for (guint i = 0; i != selection->len; i++)
+            frida_application_query_options_select_identifier(options, (const gchar *) g_ptr_array_index(selection, i));
+    }
+    FridaApplicationList *list = frida_device_enumerate_applications_sync(self->device, options, NULL, error);
+    g_object_unref(options);
+    return list;
+}
+
+static void fk_app_tracker_write(FkWriter &writer, FkAppChange kind, const gchar *identifier, const gchar *name,
+                                 guint pid, GHashTable *parameters, const gchar * const *keys) {
+    writer.put_u8((guint8) kind);
+    writer.put_string(identifier);
+    writer.put_string(name);
+    writer.put_u32(pid);
+    if (parameters != NULL)
+        fk_write_variant_dict_selected(writer, parameters, keys);
+    else
+        writer.put_u32(0);
+}
+
+GBytes *fk_app_tracker_poll(FkAppTracker *self, GError **error) {
+    FridaApplicationList *current = fk_app_tracker_query(self, FRIDA_SCOPE_MINIMAL, NULL, error);
+    if (current == NULL)
+        return NULL;
+
+    FkWriter writer;
+    guint32 count = 0;
+    writer.put_u32(0);
+
+    // The lock only covers the diff and the swap of `known`; both queries run
+    // outside it so reset() never waits on a device round trip. Whatever the
+    // FULL query needs is copied into `pending` first, as `known` may be reset
+    // under our feet once the lock is dropped.
+    GHashTable *pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, fk_app_state_free);
+    GHashTable *added = g_hash_table_new(g_str_hash, g_str_equal);
+    GPtrArray *dirty = g_ptr_array_new();
+    gboolean everything;
+
+    g_mutex_lock(&self->lock);
+
+    // Diff against the cached list, leaving in `known` only what disappeared.
+    GHashTable *next = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, fk_app_state_free);
+
+    gint size = frida_application_list_size(current);
+    for (gint i = 0; i != size; i++) {
+        FridaApplication *application = frida_application_list_get(current, i);
+        const gchar *identifier = frida_application_get_identifier(application);
+
+        FkAppState *state = g_new0(FkAppState, 1);
+        state->name = g_strdup(frida_application_get_name(application));
+        state->pid = frida_application_get_pid(application);
+
+        FkAppState *previous = (FkAppState *) g_hash_table_lookup(self->known, identifier);
+        if (previous == NULL || previous->pid != state->pid || g_strcmp0(previous->name, state->name) != 0) {
+            FkAppState *copy = g_new0(FkAppState, 1);
+            copy->name = g_strdup(state->name);
+            copy->pid = state->pid;
+            gchar *key = g_strdup(identifier);
+            g_hash_table_insert(pending, key, copy);
+            g_ptr_array_add(dirty, key);
+            if (previous == NULL)
+                g_hash_table_add(added, key);
+        }
+        g_hash_table_remove(self->known, identifier);
+        g_hash_table_insert(next, g_strdup(identifier), state);
+
+        g_object_unref(application);
+    }
+    g_object_unref(current);
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, self->known);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        FkAppState *state = (FkAppState *) value;
+        fk_app_tracker_write(writer, FK_APP_REMOVED, (const gchar *) key, state->name, state->pid, NULL, NULL);
+        count++;
+    }
+
+    // When everything is new, skip the selection and fetch the whole list.
+    everything = dirty->len == g_hash_table_size(next);
+
+    g_hash_table_unref(self->known);
+    self->known = next;
+
+    g_mutex_unlock(&self->lock);
+
+    if (dirty->len != 0) {
+        GError *full_error = NULL;
+        FridaApplicationList *full =
+            fk_app_tracker_query(self, FRIDA_SCOPE_FULL, everything ? NULL : dirty, &full_error);
+
+        GHashTable *reported = g_hash_table_new(g_str_hash, g_str_equal);
+        gint full_size = full != NULL ? frida_application_list_size(full) : 0;
+        for (gint i = 0; i != full_size; i++) {
+            FridaApplication *application = frida_application_list_get(full, i);
+            const gchar *identifier = frida_application_get_identifier(application);
+            gpointer dirty_key;
+            if (g_hash_table_lookup_extended(pending, identifier, &dirty_key, NULL) &&
+                g_hash_table_add(reported, dirty_key)) {
+                fk_app_tracker_write(writer, g_hash_table_contains(added, identifier) ? FK_APP_ADDED : FK_APP_CHANGED,
+                                     identifier, frida_application_get_name(application),
+                                     frida_application_get_pid(application),
+                                     frida_application_get_parameters(application), self->keys);
+                count++;
+            }
+            g_object_unref(application);
+        }
+        if (full != NULL)
+            g_object_unref(full);
+        g_clear_error(&full_error);
+
+        // Whatever the FULL query missed is still reported, just without
+        // parameters.
+        for (guint i = 0; i != dirty->len; i++) {
+            const gchar *identifier = (const gchar *) g_ptr_array_index(dirty, i);
+            if (g_hash_table_contains(reported, identifier))
+                continue;
+            FkAppState *state = (FkAppState *) g_hash_table_lookup(pending, identifier);
+            fk_app_tracker_write(writer, g_hash_table_contains(added, identifier) ? FK_APP_ADDED : FK_APP_CHANGED,
+                                 identifier, state->name, state->pid, NULL, NULL);
+            count++;
+        }
+        g_hash_table_unref(reported);
+    }
+
+    g_ptr_array_unref(dirty);
+    g_hash_table_unref(added);
+    g_hash_table_unref(pending);
+
+    writer.patch_u32(0, count);
+    return writer.steal();
+}
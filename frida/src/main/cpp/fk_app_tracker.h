@@ -0,0 +1,32 @@
+#ifndef __FK_APP_TRACKER_H__
+#define __FK_APP_TRACKER_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Incremental application enumeration for one device. Each poll runs a cheap
+// MINIMAL-scope query, diffs it against the list cached from the previous
+// poll, and fetches FULL-scope parameters only for applications that were
+// added or whose pid or name changed, selected by identifier. A poll returns
+//   u32 count, count x (u8 FkAppChange, string identifier, string name,
+//                       u32 pid, variant dict parameters)
+// where parameters are filtered by keys as in fk_device_query.h and are
+// always empty for FK_APP_REMOVED. The first poll reports everything as added.
+typedef struct _FkAppTracker FkAppTracker;
+
+typedef enum {
+    FK_APP_ADDED,
+    FK_APP_REMOVED,
+    FK_APP_CHANGED
+} FkAppChange;
+
+FkAppTracker *fk_app_tracker_new(FridaDevice *device, const gchar *keys);
+void fk_app_tracker_free(FkAppTracker *self);
+
+GBytes *fk_app_tracker_poll(FkAppTracker *self, GError **error);
+void fk_app_tracker_reset(FkAppTracker *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,242 @@
+#include "fk_auth_service.h"
+#include "fk_writer.h"
+
+struct FkAuthEntry {
+    gchar *key;
+    gchar *session_info;
+    gint64 expires;
+};
+
+struct FkAuthRequest {
+    guint id;
+    gchar *key;
+    GPtrArray *tasks;
+};
+
+struct _FkAuthService {
+    GObject parent;
+
+    FkEventQueue *requests;
+    guint capacity;
+    gint64 ttl_us;
+    GMutex lock;
+    GQueue entries;
+    GHashTable *entry_by_key;
+    GHashTable *request_by_key;
+    GHashTable *request_by_id;
+    guint next_id;
+    gboolean closed;
+};
+
+static void fk_auth_service_iface_init(FridaAuthenticationServiceIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FkAuthService, fk_auth_service, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(FRIDA_TYPE_AUTHENTICATION_SERVICE, fk_auth_service_iface_init))
+
+static void fk_auth_entry_free(FkAuthEntry *entry) {
+    g_free(entry->key);
+    g_free(entry->session_info);
+    g_free(entry);
+}
+
+static void fk_auth_request_free(FkAuthRequest *request) {
+    g_ptr_array_unref(request->tasks);
+    g_free(request->key);
+    g_free(request);
+}
+
+static gchar *fk_auth_service_key(const gchar *token) {
+    return g_compute_checksum_for_string(G_CHECKSUM_SHA256, token, -1);
+}
+
+// Called with the lock held.
+static const gchar *fk_auth_service_lookup(FkAuthService *self, const gchar *key) {
+    GList *link = (GList *) g_hash_table_lookup(self->entry_by_key, key);
+    if (link == NULL)
+        return NULL;
+
+    FkAuthEntry *entry = (FkAuthEntry *) link->data;
+    if (entry->expires != 0 && g_get_monotonic_time() >= entry->expires) {
+        g_hash_table_remove(self->entry_by_key, key);
+        g_queue_delete_link(&self->entries, link);
+        fk_auth_entry_free(entry);
+        return NULL;
+    }
+
+    g_queue_unlink(&self->entries, link);
+    g_queue_push_head_link(&self->entries, link);
+    return entry->session_info;
+}
+
+// Called with the lock held.
+static void fk_auth_service_remember(FkAuthService *self, const gchar *key, const gchar *session_info) {
+    if (self->capacity == 0 || g_hash_table_contains(self->entry_by_key, key))
+        return;
+
+    FkAuthEntry *entry = g_new0(FkAuthEntry, 1);
+    entry->key = g_strdup(key);
+    entry->session_info = g_strdup(session_info);
+    entry->expires = self->ttl_us != 0 ? g_get_monotonic_time() + self->ttl_us : 0;
+    g_queue_push_head(&self->entries, entry);
+    g_hash_table_insert(self->entry_by_key, entry->key, self->entries.head);
+
+    while (self->entries.length > self->capacity) {
+        FkAuthEntry *evicted = (FkAuthEntry *) g_queue_pop_tail(&self->entries);
+        g_hash_table_remove(self->entry_by_key, evicted->key);
+        fk_auth_entry_free(evicted);
+    }
+}
+
+static void fk_auth_service_finish_request(FkAuthRequest *request, const gchar *session_info, const gchar *reason) {
+    for (guint i = 0; i != request->tasks->len; i++) {
+        GTask *task = (GTask *) g_ptr_array_index(request->tasks, i);
+        if (session_info != NULL)
+            g_task_return_pointer(task, g_strdup(session_info), g_free);
+        else
+            g_task_return_new_error(task, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT, "%s", reason);
+    }
+    fk_auth_request_free(request);
+}
+
+static void fk_auth_service_authenticate(FridaAuthenticationService *service, const gchar *token,
+                                         GCancellable *cancellable, GAsyncReadyCallback callback, gpointer user_data) {
+    FkAuthService *self = FK_AUTH_SERVICE(service);
+    GTask *task = g_task_new(self, cancellable, callback, user_data);
+    gchar *key = fk_auth_service_key(token);
+
+    g_mutex_lock(&self->lock);
+
+    if (self->closed) {
+        g_mutex_unlock(&self->lock);
+        g_task_return_new_error(task, FRIDA_ERROR, FRIDA_ERROR_INVALID_OPERATION, "Authentication service closed");
+        g_object_unref(task);
+        g_free(key);
+        return;
+    }
+
+    const gchar *cached = fk_auth_service_lookup(self, key);
+    if (cached != NULL) {
+        gchar *session_info = g_strdup(cached);
+        g_mutex_unlock(&self->lock);
+        g_task_return_pointer(task, session_info, g_free);
+        g_object_unref(task);
+        g_free(key);
+        return;
+    }
+
+    // Handshakes racing on the same token share one upcall.
+    FkAuthRequest *request = (FkAuthRequest *) g_hash_table_lookup(self->request_by_key, key);
+    if (request != NULL) {
+        g_ptr_array_add(request->tasks, task);
+        g_mutex_unlock(&self->lock);
+        g_free(key);
+        return;
+    }
+
+    request = g_new0(FkAuthRequest, 1);
+    request->id = ++self->next_id;
+    request->key = key;
+    request->tasks = g_ptr_array_new_with_free_func(g_object_unref);
+    g_ptr_array_add(request->tasks, task);
+    g_hash_table_insert(self->request_by_key, request->key, request);
+    g_hash_table_insert(self->request_by_id, GUINT_TO_POINTER(request->id), request);
+    guint id = request->id;
+
+    g_mutex_unlock(&self->lock);
+
+    FkWriter writer;
+    writer.put_u32(id);
+    writer.put_string(token);
+    fk_event_queue_push(self->requests, writer.data(), writer.size());
+}
+
+static gchar *fk_auth_service_authenticate_finish(FridaAuthenticationService *service, GAsyncResult *result,
+                                                  GError **error) {
+    return (gchar *) g_task_propagate_pointer(G_TASK(result), error);
+}
+
+static void fk_auth_service_iface_init(FridaAuthenticationServiceIface *iface) {
+    iface->authenticate = fk_auth_service_authenticate;
+    iface->authenticate_finish = fk_auth_service_authenticate_finish;
+}
+
+static void fk_auth_service_init(FkAuthService *self) {
+    g_mutex_init(&self->lock);
+    g_queue_init(&self->entries);
+    self->entry_by_key = g_hash_table_new(g_str_hash, g_str_equal);
+    self->request_by_key = g_hash_table_new(g_str_hash, g_str_equal);
+    self->request_by_id = g_hash_table_new(NULL, NULL);
+    self->requests = fk_event_queue_new(0);
+}
+
+static void fk_auth_service_finalize(GObject *object) {
+    FkAuthService *self = FK_AUTH_SERVICE(object);
+
+    g_queue_clear_full(&self->entries, (GDestroyNotify) fk_auth_entry_free);
+    g_hash_table_unref(self->entry_by_key);
+    g_hash_table_unref(self->request_by_key);
+    g_hash_table_unref(self->request_by_id);
+    fk_event_queue_free(self->requests);
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(fk_auth_service_parent_class)->finalize(object);
+}
+
+static void fk_auth_service_class_init(FkAuthServiceClass *klass) {
+    G_OBJECT_CLASS(klass)->finalize = fk_auth_service_finalize;
+}
+
+FkAuthService *fk_auth_service_new(guint capacity, guint ttl_ms) {
+    FkAuthService *self = FK_AUTH_SERVICE(g_object_new(FK_TYPE_AUTH_SERVICE, NULL));
+    self->capacity = capacity;
+    self->ttl_us = (gint64) ttl_ms * G_TIME_SPAN_MILLISECOND;
+    return self;
+}
+
+// Rejects every handshake still waiting; endpoint parameters referencing the
+// service keep it alive and fail fast from here on.
+void fk_auth_service_free(FkAuthService *self) {
+    if (self == NULL)
+        return;
+
+    g_mutex_lock(&self->lock);
+    self->closed = TRUE;
+    GList *pending = g_hash_table_get_values(self->request_by_id);
+    g_hash_table_remove_all(self->request_by_id);
+    g_hash_table_remove_all(self->request_by_key);
+    g_mutex_unlock(&self->lock);
+
+    for (GList *cur = pending; cur != NULL; cur = cur->next)
+        fk_auth_service_finish_request((FkAuthRequest *) cur->data, NULL, "Authentication service closed");
+    g_list_free(pending);
+
+    fk_event_queue_close(self->requests);
+    g_object_unref(self);
+}
+
+void fk_auth_service_complete(FkAuthService *self, guint id, const gchar *session_info) {
+    g_mutex_lock(&self->lock);
+    FkAuthRequest *request = (FkAuthRequest *) g_hash_table_lookup(self->request_by_id, GUINT_TO_POINTER(id));
+    if (request == NULL) {
+        g_mutex_unlock(&self->lock);
+        return;
+    }
+    g_hash_table_remove(self->request_by_id, GUINT_TO_POINTER(id));
+    g_hash_table_remove(self->request_by_key, request->key);
+    if (session_info != NULL)
+        fk_auth_service_remember(self, request->key, session_info);
+    g_mutex_unlock(&self->lock);
+
+    fk_auth_service_finish_request(request, session_info, "Incorrect token");
+}
+
+void fk_auth_service_forget_all(FkAuthService *self) {
+    g_mutex_lock(&self->lock);
+    g_hash_table_remove_all(self->entry_by_key);
+    g_queue_clear_full(&self->entries, (GDestroyNotify) fk_auth_entry_free);
+    g_mutex_unlock(&self->lock);
+}
+
+FkEventQueue *fk_auth_service_get_requests(FkAuthService *self) {
+    return self->requests;
+}
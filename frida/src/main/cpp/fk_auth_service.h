@@ -0,0 +1,29 @@
+#ifndef __FK_AUTH_SERVICE_H__
+#define __FK_AUTH_SERVICE_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// A FridaAuthenticationService that hands tokens to the JVM instead of
+// checking them on the main context. Each unknown token is published once as
+//   u32 request id, string token
+// and connections presenting it wait until fk_auth_service_complete is called
+// for that id, from any thread. Accepted tokens are kept in an LRU of
+// capacity entries for ttl_ms (0 keeps them until evicted); later handshakes
+// with them never leave the main context. Tokens are only held hashed.
+#define FK_TYPE_AUTH_SERVICE (fk_auth_service_get_type())
+G_DECLARE_FINAL_TYPE(FkAuthService, fk_auth_service, FK, AUTH_SERVICE, GObject)
+
+FkAuthService *fk_auth_service_new(guint capacity, guint ttl_ms);
+void fk_auth_service_free(FkAuthService *self);
+
+// session_info is the JSON handed to frida for an accepted token; NULL rejects it.
+void fk_auth_service_complete(FkAuthService *self, guint id, const gchar *session_info);
+void fk_auth_service_forget_all(FkAuthService *self);
+FkEventQueue *fk_auth_service_get_requests(FkAuthService *self);
+
+G_END_DECLS
+
+#endif
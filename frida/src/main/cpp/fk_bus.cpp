@@ -0,0 +1,150 @@
+#include "fk_bus.h"
+#include "fk_main_context.h"
+#include "fk_writer.h"
+
+struct FkBusPost {
+    gchar *json;
+    GBytes *data;
+};
+
+struct _FkBus {
+    FridaBus *bus;
+    FkEventQueue *events;
+    guint coalesce_ms;
+    GMutex lock;
+    GQueue pending;
+    GSource *flush;
+    gboolean closed;
+    gulong message_handler;
+    gulong detached_handler;
+};
+
+static void fk_bus_post_free(gpointer data) {
+    FkBusPost *post = (FkBusPost *) data;
+    g_free(post->json);
+    if (post->data != NULL)
+        g_bytes_unref(post->data);
+    g_free(post);
+}
+
+static void fk_bus_on_message(FridaBus *bus, const gchar *json, GBytes *data, gpointer user_data) {
+    FkBus *self = (FkBus *) user_data;
+    FkWriter writer;
+    writer.put_u8(FK_BUS_MESSAGE);
+    writer.put_string(json);
+    writer.put_gbytes(data);
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_bus_on_detached(FridaBus *bus, gpointer user_data) {
+    FkBus *self = (FkBus *) user_data;
+    guint8 kind = FK_BUS_DETACHED;
+    fk_event_queue_push(self->events, &kind, 1);
+}
+
+static void fk_bus_connect(gpointer user_data) {
+    FkBus *self = (FkBus *) user_data;
+    if (self->message_handler != 0)
+        return;
+    self->message_handler = g_signal_connect(self->bus, "message", G_CALLBACK(fk_bus_on_message), self);
+    self->detached_handler = g_signal_connect(self->bus, "detached", G_CALLBACK(fk_bus_on_detached), self);
+}
+
+// Runs on the main context, so it never races the flush source.
+static void fk_bus_teardown(gpointer user_data) {
+    FkBus *self = (FkBus *) user_data;
+
+    if (self->message_handler != 0) {
+        g_signal_handler_disconnect(self->bus, self->message_handler);
+        g_signal_handler_disconnect(self->bus, self->detached_handler);
+    }
+
+    g_mutex_lock(&self->lock);
+    self->closed = TRUE;
+    if (self->flush != NULL) {
+        g_source_destroy(self->flush);
+        g_source_unref(self->flush);
+        self->flush = NULL;
+    }
+    GQueue batch = self->pending;
+    g_queue_init(&self->pending);
+    g_mutex_unlock(&self->lock);
+
+    // Posts accepted before close still go out rather than dying with the
+    // coalescing window.
+    FkBusPost *post;
+    while ((post = (FkBusPost *) g_queue_pop_head(&batch)) != NULL) {
+        frida_bus_post(self->bus, post->json, post->data);
+        fk_bus_post_free(post);
+    }
+}
+
+FkBus *fk_bus_new(FridaDevice *device, guint capacity, guint coalesce_ms) {
+    FkBus *self = g_new0(FkBus, 1);
+    self->bus = (FridaBus *) g_object_ref(frida_device_get_bus(device));
+    self->events = fk_event_queue_new(capacity);
+    self->coalesce_ms = coalesce_ms;
+    g_mutex_init(&self->lock);
+    g_queue_init(&self->pending);
+    return self;
+}
+
+void fk_bus_free(FkBus *self) {
+    if (self == NULL)
+        return;
+    fk_invoke_sync(fk_bus_teardown, self);
+    g_mutex_clear(&self->lock);
+    fk_event_queue_close(self->events);
+    fk_event_queue_free(self->events);
+    g_object_unref(self->bus);
+    g_free(self);
+}
+
+void fk_bus_attach_sync(FkBus *self, GError **error) {
+    fk_invoke_sync(fk_bus_connect, self);
+    frida_bus_attach_sync(self->bus, NULL, error);
+}
+
+static gboolean fk_bus_flush(gpointer user_data) {
+    FkBus *self = (FkBus *) user_data;
+
+    g_mutex_lock(&self->lock);
+    GQueue batch = self->pending;
+    g_queue_init(&self->pending);
+    g_source_unref(self->flush);
+    self->flush = NULL;
+    g_mutex_unlock(&self->lock);
+
+    FkBusPost *post;
+    while ((post = (FkBusPost *) g_queue_pop_head(&batch)) != NULL) {
+        frida_bus_post(self->bus, post->json, post->data);
+        fk_bus_post_free(post);
+    }
+
+    return G_SOURCE_REMOVE;
+}
+
+void fk_bus_post(FkBus *self, const gchar *json, GBytes *data) {
+    FkBusPost *post = g_new0(FkBusPost, 1);
+    post->json = g_strdup(json);
+    post->data = data != NULL ? g_bytes_ref(data) : NULL;
+
+    g_mutex_lock(&self->lock);
+    if (self->closed) {
+        g_mutex_unlock(&self->lock);
+        fk_bus_post_free(post);
+        return;
+    }
+    g_queue_push_tail(&self->pending, post);
+    if (self->flush == NULL)
+        self->flush = fk_schedule(self->coalesce_ms, fk_bus_flush, self, NULL);
+    g_mutex_unlock(&self->lock);
+}
+
+gboolean fk_bus_is_detached(FkBus *self) {
+    return frida_bus_is_detached(self->bus);
+}
+
+FkEventQueue *fk_bus_get_events(FkBus *self) {
+    return self->events;
+}
@@ -0,0 +1,32 @@
+#ifndef __FK_BUS_H__
+#define __FK_BUS_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Device bus with batched delivery in both directions. Incoming messages go
+// through a bounded event queue; outgoing posts are queued and flushed by a
+// single source on the frida main context, at most coalesce_ms after the
+// first one, so a burst of posts costs one wakeup. Events:
+//   FK_BUS_MESSAGE:  u8 kind, string json, blob data
+//   FK_BUS_DETACHED: u8 kind
+typedef struct _FkBus FkBus;
+
+typedef enum {
+    FK_BUS_MESSAGE,
+    FK_BUS_DETACHED
+} FkBusEvent;
+
+FkBus *fk_bus_new(FridaDevice *device, guint capacity, guint coalesce_ms);
+void fk_bus_free(FkBus *self);
+
+void fk_bus_attach_sync(FkBus *self, GError **error);
+void fk_bus_post(FkBus *self, const gchar *json, GBytes *data);
+gboolean fk_bus_is_detached(FkBus *self);
+FkEventQueue *fk_bus_get_events(FkBus *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,250 @@
+#include "fk_channel.h"
+#include "fk_main_context.h"
+#include "fk_ring.h"
+
+struct _FkChannel {
+    volatile gint ref_count;
+    GIOStream *stream;
+    GCancellable *cancellable;
+    gboolean nonblocking;
+
+    GMutex lock;
+    GCond cond;
+    FkRing *incoming;
+    FkRing *outgoing;
+    gboolean reading;
+    gboolean writing;
+    gboolean eof;
+    gboolean closed;
+    GError *error;
+};
+
+static void fk_channel_pump_read(gpointer user_data);
+static void fk_channel_pump_write(gpointer user_data);
+
+FkChannel *fk_channel_new(GIOStream *stream, gboolean nonblocking, guint capacity) {
+    FkChannel *self = g_new0(FkChannel, 1);
+    self->ref_count = 1;
+    self->stream = (GIOStream *) g_object_ref(stream);
+    self->cancellable = g_cancellable_new();
+    self->nonblocking = nonblocking;
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+
+    if (nonblocking) {
+        self->incoming = new FkRing(capacity);
+        self->outgoing = new FkRing(capacity);
+        fk_invoke_async(fk_channel_pump_read, fk_channel_ref(self), (GDestroyNotify) fk_channel_unref);
+    }
+
+    return self;
+}
+
+FkChannel *fk_channel_open_sync(FridaDevice *device, const gchar *address, gboolean nonblocking, guint capacity,
+                                GError **error) {
+    GIOStream *stream = frida_device_open_channel_sync(device, address, NULL, error);
+    if (stream == NULL)
+        return NULL;
+    FkChannel *self = fk_channel_new(stream, nonblocking, capacity);
+    g_object_unref(stream);
+    return self;
+}
+
+FkChannel *fk_channel_ref(FkChannel *self) {
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+static void fk_channel_close_stream(gpointer user_data) {
+    g_io_stream_close_async(G_IO_STREAM(user_data), G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+}
+
+void fk_channel_unref(FkChannel *self) {
+    if (self == NULL || !g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+    // Async operations hold refs, so nothing is pending on the stream here.
+    // Closing is left to the main context, where frida's streams live.
+    fk_invoke_async(fk_channel_close_stream, self->stream, g_object_unref);
+    g_object_unref(self->cancellable);
+    delete self->incoming;
+    delete self->outgoing;
+    g_clear_error(&self->error);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+    g_free(self);
+}
+
+void fk_channel_close(FkChannel *self) {
+    g_mutex_lock(&self->lock);
+    self->closed = TRUE;
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    g_cancellable_cancel(self->cancellable);
+}
+
+// Caller holds the lock.
+static void fk_channel_fail(FkChannel *self, GError *error) {
+    if (self->error == NULL && !g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        self->error = error;
+    else
+        g_error_free(error);
+}
+
+static gint fk_channel_take_error(FkChannel *self, GError **error) {
+    g_propagate_error(error, self->error);
+    self->error = NULL;
+    return -1;
+}
+
+static void fk_channel_on_read(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkChannel *self = (FkChannel *) user_data;
+    GError *error = NULL;
+    gssize n = g_input_stream_read_finish(G_INPUT_STREAM(source), result, &error);
+
+    g_mutex_lock(&self->lock);
+    self->reading = FALSE;
+    if (n > 0)
+        self->incoming->commit((gsize) n);
+    else if (n == 0)
+        self->eof = TRUE;
+    else
+        fk_channel_fail(self, error);
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    fk_channel_pump_read(self);
+    fk_channel_unref(self);
+}
+
+// Keeps one read in flight for as long as the incoming ring has room.
+static void fk_channel_pump_read(gpointer user_data) {
+    FkChannel *self = (FkChannel *) user_data;
+
+    g_mutex_lock(&self->lock);
+    guint8 *span;
+    gsize size = self->incoming->writable(&span);
+    gboolean start = !self->reading && !self->eof && !self->closed && self->error == NULL && size != 0;
+    if (start)
+        self->reading = TRUE;
+    g_mutex_unlock(&self->lock);
+
+    if (start) {
+        g_input_stream_read_async(g_io_stream_get_input_stream(self->stream), span, size, G_PRIORITY_DEFAULT,
+                                  self->cancellable, fk_channel_on_read, fk_channel_ref(self));
+    }
+}
+
+static void fk_channel_on_written(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkChannel *self = (FkChannel *) user_data;
+    GError *error = NULL;
+    gssize n = g_output_stream_write_finish(G_OUTPUT_STREAM(source), result, &error);
+
+    g_mutex_lock(&self->lock);
+    self->writing = FALSE;
+    if (n >= 0)
+        self->outgoing->consume((gsize) n);
+    else
+        fk_channel_fail(self, error);
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    fk_channel_pump_write(self);
+    fk_channel_unref(self);
+}
+
+static void fk_channel_pump_write(gpointer user_data) {
+    FkChannel *self = (FkChannel *) user_data;
+
+    g_mutex_lock(&self->lock);
+    const guint8 *span;
+    gsize size = self->outgoing->readable(&span);
+    gboolean start = !self->writing && !self->closed && self->error == NULL && size != 0;
+    if (start)
+        self->writing = TRUE;
+    g_mutex_unlock(&self->lock);
+
+    if (start) {
+        g_output_stream_write_async(g_io_stream_get_output_stream(self->stream), span, size, G_PRIORITY_DEFAULT,
+                                    self->cancellable, fk_channel_on_written, fk_channel_ref(self));
+    }
+}
+
+gint fk_channel_read(FkChannel *self, gpointer buffer, gsize size, GError **error) {
+    size = MIN(size, (gsize) G_MAXINT);
+
+    if (!self->nonblocking) {
+        gssize n = g_input_stream_read(g_io_stream_get_input_stream(self->stream), buffer, size, self->cancellable,
+                                       error);
+        return n == 0 && size != 0 ? -1 : (gint) n;
+    }
+
+    g_mutex_lock(&self->lock);
+    gboolean was_full = self->incoming->space() == 0;
+    gint result = (gint) self->incoming->take((guint8 *) buffer, size);
+    if (result == 0 && self->error != NULL)
+        result = fk_channel_take_error(self, error);
+    else if (result == 0 && (self->eof || self->closed) && size != 0)
+        result = -1;
+    g_mutex_unlock(&self->lock);
+
+    // A full ring stalls the read pump; restart it now that there is room.
+    if (was_full && result > 0)
+        fk_invoke_async(fk_channel_pump_read, fk_channel_ref(self), (GDestroyNotify) fk_channel_unref);
+
+    return result;
+}
+
+gint fk_channel_write(FkChannel *self, gconstpointer buffer, gsize size, GError **error) {
+    size = MIN(size, (gsize) G_MAXINT);
+
+    if (!self->nonblocking) {
+        return (gint) g_output_stream_write(g_io_stream_get_output_stream(self->stream), buffer, size,
+                                            self->cancellable, error);
+    }
+
+    g_mutex_lock(&self->lock);
+    gint result;
+    if (self->error != NULL) {
+        result = fk_channel_take_error(self, error);
+    } else if (self->closed) {
+        g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_CLOSED, "Channel is closed");
+        result = -1;
+    } else {
+        result = (gint) self->outgoing->put((const guint8 *) buffer, size);
+    }
+    gboolean idle = !self->writing;
+    g_mutex_unlock(&self->lock);
+
+    if (result > 0 && idle)
+        fk_invoke_async(fk_channel_pump_write, fk_channel_ref(self), (GDestroyNotify) fk_channel_unref);
+
+    return result;
+}
+
+gint fk_channel_poll(FkChannel *self, gint interest, gint timeout_ms) {
+    if (!self->nonblocking)
+        return interest;
+
+    g_mutex_lock(&self->lock);
+
+    gint64 deadline = g_get_monotonic_time() + (gint64) timeout_ms * G_TIME_SPAN_MILLISECOND;
+    gint ready;
+    while (TRUE) {
+        gboolean done = self->eof || self->closed || self->error != NULL;
+        ready = 0;
+        if ((interest & FK_CHANNEL_READABLE) != 0 && (self->incoming->size() != 0 || done))
+            ready |= FK_CHANNEL_READABLE;
+        if ((interest & FK_CHANNEL_WRITABLE) != 0 && (self->outgoing->space() != 0 || done))
+            ready |= FK_CHANNEL_WRITABLE;
+        if (ready != 0 || timeout_ms == 0)
+            break;
+        if (timeout_ms < 0)
+            g_cond_wait(&self->cond, &self->lock);
+        else if (!g_cond_wait_until(&self->cond, &self->lock, deadline))
+            break;
+    }
+
+    g_mutex_unlock(&self->lock);
+    return ready;
+}
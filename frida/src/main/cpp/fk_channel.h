@@ -0,0 +1,46 @@
+#ifndef __FK_CHANNEL_H__
+#define __FK_CHANNEL_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// A device channel (frida_device_open_channel_sync) read and written straight
+// from caller-provided memory.
+//
+// Blocking channels call g_input_stream_read/g_output_stream_write on the
+// caller's buffer and may be used from any thread. Non-blocking channels are
+// driven by async operations on the frida main context that read into and
+// write out of two rings of `capacity` bytes; read/write then only copy
+// between the caller's buffer and a ring and never wait, and poll waits for
+// readiness.
+typedef struct _FkChannel FkChannel;
+
+typedef enum {
+    FK_CHANNEL_READABLE = 1 << 0,
+    FK_CHANNEL_WRITABLE = 1 << 1
+} FkChannelReadiness;
+
+FkChannel *fk_channel_open_sync(FridaDevice *device, const gchar *address, gboolean nonblocking, guint capacity,
+                                GError **error);
+// Wraps an already open stream; takes a ref.
+FkChannel *fk_channel_new(GIOStream *stream, gboolean nonblocking, guint capacity);
+FkChannel *fk_channel_ref(FkChannel *self);
+void fk_channel_unref(FkChannel *self);
+
+// Cancels pending operations and closes the stream once they are done.
+void fk_channel_close(FkChannel *self);
+
+// Bytes transferred, -1 on end of stream (reads only), and in non-blocking
+// mode 0 when the operation would block. Errors are reported once.
+gint fk_channel_read(FkChannel *self, gpointer buffer, gsize size, GError **error);
+gint fk_channel_write(FkChannel *self, gconstpointer buffer, gsize size, GError **error);
+
+// Non-blocking mode only: waits up to timeout_ms (forever when negative) for
+// any of the requested FkChannelReadiness bits and returns those that are set.
+// End of stream, errors and close count as readable.
+gint fk_channel_poll(FkChannel *self, gint interest, gint timeout_ms);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,261 @@
+#include "fk_child_follower.h"
+#include "fk_main_context.h"
+#include "fk_marshal.h"
+
+struct _FkChildFollower {
+    volatile gint ref_count;
+    FridaDevice *device;
+    FkAgent *agent;
+    FkEventQueue *events;
+    GHashTable *lineage;
+    GHashTable *in_flight;
+    gulong child_added_handler;
+};
+
+// A pid this follower instrumented, watched through its session so the entry
+// goes away with the process. Only an exec keeps it past detach, without a
+// session, until the replacing image shows up as a child.
+struct FkChildLineage {
+    FkChildFollower *follower;
+    guint pid;
+    FridaSession *session;
+    gulong detached_handler;
+};
+
+struct FkChildJob {
+    FkChildFollower *follower;
+    FridaChild *child;
+    gint64 started;
+};
+
+static FkChildFollower *fk_child_follower_ref(FkChildFollower *self) {
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+static void fk_child_follower_unref(FkChildFollower *self) {
+    if (!g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+    fk_event_queue_free(self->events);
+    g_hash_table_unref(self->in_flight);
+    g_hash_table_unref(self->lineage);
+    fk_agent_unref(self->agent);
+    g_object_unref(self->device);
+    g_free(self);
+}
+
+static void fk_child_lineage_forget(FkChildLineage *entry) {
+    if (entry->session == NULL)
+        return;
+    g_signal_handler_disconnect(entry->session, entry->detached_handler);
+    g_clear_object(&entry->session);
+}
+
+static void fk_child_lineage_free(gpointer data) {
+    FkChildLineage *entry = (FkChildLineage *) data;
+    fk_child_lineage_forget(entry);
+    g_free(entry);
+}
+
+static void fk_child_lineage_on_detached(FridaSession *session, FridaSessionDetachReason reason, FridaCrash *crash,
+                                         gpointer user_data) {
+    FkChildLineage *entry = (FkChildLineage *) user_data;
+
+    // Keep the session alive until the emission is over.
+    g_object_ref(session);
+    if (reason == FRIDA_SESSION_DETACH_REASON_PROCESS_REPLACED)
+        fk_child_lineage_forget(entry);
+    else
+        g_hash_table_remove(entry->follower->lineage, GUINT_TO_POINTER(entry->pid));
+    g_object_unref(session);
+}
+
+static void fk_child_follower_remember(FkChildFollower *self, guint pid) {
+    FridaSession *session = fk_agent_get_session(self->agent, self->device, pid);
+    if (session == NULL || self->child_added_handler == 0)
+        return;
+
+    FkChildLineage *entry = g_new0(FkChildLineage, 1);
+    entry->follower = self;
+    entry->pid = pid;
+    entry->session = (FridaSession *) g_object_ref(session);
+    entry->detached_handler =
+        g_signal_connect(session, "detached", G_CALLBACK(fk_child_lineage_on_detached), entry);
+    g_hash_table_replace(self->lineage, GUINT_TO_POINTER(pid), entry);
+}
+
+static void fk_child_follower_publish(FkChildJob *job, FkChildEvent kind, const gchar *error) {
+    FkWriter writer;
+    writer.put_u8((guint8) kind);
+    fk_write_child(writer, job->child);
+    writer.put_string(error);
+    writer.put_i64(g_get_monotonic_time() - job->started);
+    fk_event_queue_push(job->follower->events, writer.data(), writer.size());
+}
+
+static void fk_child_job_free(FkChildJob *job) {
+    g_hash_table_remove(job->follower->in_flight, GUINT_TO_POINTER(frida_child_get_pid(job->child)));
+    fk_child_follower_unref(job->follower);
+    g_object_unref(job->child);
+    g_free(job);
+}
+
+static void fk_child_follower_on_resumed(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkChildJob *job = (FkChildJob *) user_data;
+    GError *error = NULL;
+
+    frida_device_resume_finish((FridaDevice *) source, result, &error);
+    if (error == NULL) {
+        fk_child_follower_publish(job, FK_CHILD_RESUMED, NULL);
+    } else {
+        fk_child_follower_publish(job, FK_CHILD_FAILED, error->message);
+        g_error_free(error);
+    }
+
+    fk_child_job_free(job);
+}
+
+static void fk_child_follower_on_loaded(FkAgent *agent, guint pid, const GError *error, gpointer user_data) {
+    FkChildJob *job = (FkChildJob *) user_data;
+
+    if (error == NULL) {
+        fk_child_follower_remember(job->follower, pid);
+        fk_child_follower_publish(job, FK_CHILD_INSTRUMENTED, NULL);
+    } else {
+        fk_child_follower_publish(job, FK_CHILD_FAILED, error->message);
+    }
+
+    frida_device_resume(job->follower->device, pid, NULL, fk_child_follower_on_resumed, job);
+}
+
+// Only children of processes this agent instruments are ours; on exec the
+// parent's session is already gone by now, hence the lineage set. An exec
+// entry is used up here; loading into the new image records it afresh.
+static gboolean fk_child_follower_owns(FkChildFollower *self, FridaChild *child) {
+    guint parent = frida_child_get_parent_pid(child);
+    if (fk_agent_is_loaded_into(self->agent, self->device, parent))
+        return TRUE;
+
+    FkChildLineage *entry = (FkChildLineage *) g_hash_table_lookup(self->lineage, GUINT_TO_POINTER(parent));
+    if (entry == NULL)
+        return FALSE;
+    if (entry->session == NULL)
+        g_hash_table_remove(self->lineage, GUINT_TO_POINTER(parent));
+    return TRUE;
+}
+
+static void fk_child_follower_handle(FkChildFollower *self, FridaChild *child) {
+    guint pid = frida_child_get_pid(child);
+
+    if (!fk_child_follower_owns(self, child) || !g_hash_table_add(self->in_flight, GUINT_TO_POINTER(pid)))
+        return;
+
+    FkChildJob *job = g_new0(FkChildJob, 1);
+    job->follower = fk_child_follower_ref(self);
+    job->child = (FridaChild *) g_object_ref(child);
+    job->started = g_get_monotonic_time();
+
+    fk_child_follower_publish(job, FK_CHILD_ADDED, NULL);
+    fk_agent_load(self->agent, self->device, pid, fk_child_follower_on_loaded, job);
+}
+
+static void fk_child_follower_on_child_added(FridaDevice *device, FridaChild *child, gpointer user_data) {
+    fk_child_follower_handle((FkChildFollower *) user_data, child);
+}
+
+FkChildFollower *fk_child_follower_new(FridaDevice *device, FkAgent *agent) {
+    FkChildFollower *self = g_new0(FkChildFollower, 1);
+    self->ref_count = 1;
+    self->device = (FridaDevice *) g_object_ref(device);
+    self->agent = fk_agent_ref(agent);
+    self->events = fk_event_queue_new(0);
+    self->lineage = g_hash_table_new_full(NULL, NULL, NULL, fk_child_lineage_free);
+    self->in_flight = g_hash_table_new(NULL, NULL);
+    return self;
+}
+
+void fk_child_follower_free(FkChildFollower *self) {
+    if (self == NULL)
+        return;
+    fk_child_follower_stop_sync(self);
+    fk_event_queue_close(self->events);
+    fk_child_follower_unref(self);
+}
+
+static void fk_child_follower_begin(gpointer user_data) {
+    FkChildFollower *self = (FkChildFollower *) user_data;
+
+    if (self->child_added_handler != 0)
+        return;
+    self->child_added_handler =
+        g_signal_connect(self->device, "child-added", G_CALLBACK(fk_child_follower_on_child_added), self);
+    fk_agent_acquire_child_gating(self->agent, self->device);
+}
+
+static void fk_child_follower_end(gpointer user_data) {
+    FkChildFollower *self = (FkChildFollower *) user_data;
+
+    if (self->child_added_handler != 0) {
+        g_signal_handler_disconnect(self->device, self->child_added_handler);
+        self->child_added_handler = 0;
+        fk_agent_release_child_gating(self->agent, self->device);
+    }
+    // Disconnected here, on the main context, where the detached handlers run.
+    g_hash_table_remove_all(self->lineage);
+}
+
+struct FkChildBacklog {
+    FkChildFollower *follower;
+    FridaChildList *pending;
+};
+
+static void fk_child_follower_drain_pending(gpointer user_data) {
+    FkChildBacklog *backlog = (FkChildBacklog *) user_data;
+
+    gint size = frida_child_list_size(backlog->pending);
+    for (gint i = 0; i != size; i++) {
+        FridaChild *child = frida_child_list_get(backlog->pending, i);
+        fk_child_follower_handle(backlog->follower, child);
+        g_object_unref(child);
+    }
+}
+
+void fk_child_follower_start_sync(FkChildFollower *self, GError **error) {
+    fk_invoke_sync(fk_child_follower_begin, self);
+
+    FkChildBacklog backlog = { self, frida_device_enumerate_pending_children_sync(self->device, NULL, error) };
+    if (backlog.pending == NULL) {
+        // The caller sees start() fail, so do not leave it half running.
+        fk_invoke_sync(fk_child_follower_end, self);
+        return;
+    }
+    fk_invoke_sync(fk_child_follower_drain_pending, &backlog);
+    g_object_unref(backlog.pending);
+}
+
+void fk_child_follower_stop_sync(FkChildFollower *self) {
+    fk_invoke_sync(fk_child_follower_end, self);
+}
+
+FkEventQueue *fk_child_follower_get_events(FkChildFollower *self) {
+    return self->events;
+}
+
+// u32 count, count x child (see fk_marshal.h)
+GBytes *fk_device_enumerate_pending_children(FridaDevice *device, GError **error) {
+    FridaChildList *list = frida_device_enumerate_pending_children_sync(device, NULL, error);
+    if (list == NULL)
+        return NULL;
+
+    FkWriter writer;
+    gint size = frida_child_list_size(list);
+    writer.put_u32((guint32) size);
+    for (gint i = 0; i != size; i++) {
+        FridaChild *child = frida_child_list_get(list, i);
+        fk_write_child(writer, child);
+        g_object_unref(child);
+    }
+    g_object_unref(list);
+
+    return writer.steal();
+}
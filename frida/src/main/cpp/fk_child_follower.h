@@ -0,0 +1,36 @@
+#ifndef __FK_CHILD_FOLLOWER_H__
+#define __FK_CHILD_FOLLOWER_H__
+
+#include "frida_core.h"
+#include "fk_agent.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Follow-children mode: enables child gating on the sessions the agent is
+// loaded into on this device only (shared with other followers by count), and on child-added loads the same (cached) agent
+// into the child and resumes it, all on the frida main context. Since each new
+// session is gated as well, whole fork/exec trees are followed. Events:
+//   u8 FkChildEvent, child (see fk_marshal.h), string error,
+//   i64 elapsed us (since child-added)
+typedef struct _FkChildFollower FkChildFollower;
+
+typedef enum {
+    FK_CHILD_ADDED,
+    FK_CHILD_INSTRUMENTED,
+    FK_CHILD_RESUMED,
+    FK_CHILD_FAILED
+} FkChildEvent;
+
+FkChildFollower *fk_child_follower_new(FridaDevice *device, FkAgent *agent);
+void fk_child_follower_free(FkChildFollower *self);
+
+void fk_child_follower_start_sync(FkChildFollower *self, GError **error);
+void fk_child_follower_stop_sync(FkChildFollower *self);
+FkEventQueue *fk_child_follower_get_events(FkChildFollower *self);
+
+GBytes *fk_device_enumerate_pending_children(FridaDevice *device, GError **error);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,185 @@
+#include "fk_crash_collector.h"
+#include "fk_main_context.h"
+#include "fk_marshal.h"
+
+struct FkCrashGroup {
+    guint id;
+    guint count;
+    gchar *summary;
+    FridaCrash *first;
+};
+
+struct _FkCrashCollector {
+    FkDeviceRegistry *registry;
+    FkEventQueue *events;
+    GMutex lock;
+    GHashTable *by_summary;
+    GHashTable *by_id;
+    guint next_id;
+    GHashTable *device_handlers;
+    gulong added_handler;
+    gulong removed_handler;
+};
+
+static void fk_crash_group_free(gpointer data) {
+    FkCrashGroup *group = (FkCrashGroup *) data;
+    g_object_unref(group->first);
+    g_free(group->summary);
+    g_free(group);
+}
+
+static void fk_crash_collector_on_crashed(FridaDevice *device, FridaCrash *crash, gpointer user_data) {
+    FkCrashCollector *self = (FkCrashCollector *) user_data;
+    const gchar *summary = frida_crash_get_summary(crash);
+    if (summary == NULL)
+        summary = "";
+
+    g_mutex_lock(&self->lock);
+    FkCrashGroup *group = (FkCrashGroup *) g_hash_table_lookup(self->by_summary, summary);
+    gboolean is_new = group == NULL;
+    if (is_new) {
+        group = g_new0(FkCrashGroup, 1);
+        group->id = ++self->next_id;
+        group->summary = g_strdup(summary);
+        group->first = (FridaCrash *) g_object_ref(crash);
+        g_hash_table_insert(self->by_summary, group->summary, group);
+        g_hash_table_insert(self->by_id, GUINT_TO_POINTER(group->id), group);
+    }
+    guint id = group->id;
+    guint count = ++group->count;
+    g_mutex_unlock(&self->lock);
+
+    FkWriter writer;
+    writer.put_u8((guint8) (is_new ? FK_CRASH_NEW : FK_CRASH_REPEATED));
+    writer.put_u32(id);
+    writer.put_string(frida_device_get_id(device));
+    writer.put_u32(frida_crash_get_pid(crash));
+    if (is_new) {
+        writer.put_string(frida_crash_get_process_name(crash));
+        writer.put_string(summary);
+    } else {
+        writer.put_u32(count);
+    }
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_crash_collector_watch(FkCrashCollector *self, FridaDevice *device) {
+    if (g_hash_table_contains(self->device_handlers, device))
+        return;
+    gulong handler = g_signal_connect(device, "process-crashed", G_CALLBACK(fk_crash_collector_on_crashed), self);
+    g_hash_table_insert(self->device_handlers, g_object_ref(device), GSIZE_TO_POINTER(handler));
+}
+
+static void fk_crash_collector_unwatch(FkCrashCollector *self, FridaDevice *device) {
+    gpointer handler;
+    if (!g_hash_table_lookup_extended(self->device_handlers, device, NULL, &handler))
+        return;
+    g_signal_handler_disconnect(device, GPOINTER_TO_SIZE(handler));
+    g_hash_table_remove(self->device_handlers, device);
+}
+
+static void fk_crash_collector_on_added(FridaDeviceManager *manager, FridaDevice *device, gpointer user_data) {
+    fk_crash_collector_watch((FkCrashCollector *) user_data, device);
+}
+
+static void fk_crash_collector_on_removed(FridaDeviceManager *manager, FridaDevice *device, gpointer user_data) {
+    fk_crash_collector_unwatch((FkCrashCollector *) user_data, device);
+}
+
+static void fk_crash_collector_begin(gpointer user_data) {
+    FkCrashCollector *self = (FkCrashCollector *) user_data;
+    FridaDeviceManager *manager = fk_device_registry_get_manager(self->registry);
+
+    self->added_handler = g_signal_connect(manager, "added", G_CALLBACK(fk_crash_collector_on_added), self);
+    self->removed_handler = g_signal_connect(manager, "removed", G_CALLBACK(fk_crash_collector_on_removed), self);
+
+    GPtrArray *devices = fk_device_registry_list(self->registry);
+    for (guint i = 0; i != devices->len; i++)
+        fk_crash_collector_watch(self, (FridaDevice *) g_ptr_array_index(devices, i));
+    g_ptr_array_unref(devices);
+}
+
+static void fk_crash_collector_end(gpointer user_data) {
+    FkCrashCollector *self = (FkCrashCollector *) user_data;
+    FridaDeviceManager *manager = fk_device_registry_get_manager(self->registry);
+
+    g_signal_handler_disconnect(manager, self->added_handler);
+    g_signal_handler_disconnect(manager, self->removed_handler);
+
+    GHashTableIter iter;
+    gpointer device, handler;
+    g_hash_table_iter_init(&iter, self->device_handlers);
+    while (g_hash_table_iter_next(&iter, &device, &handler))
+        g_signal_handler_disconnect(device, GPOINTER_TO_SIZE(handler));
+    g_hash_table_remove_all(self->device_handlers);
+}
+
+FkCrashCollector *fk_crash_collector_new(FkDeviceRegistry *registry, guint capacity) {
+    FkCrashCollector *self = g_new0(FkCrashCollector, 1);
+    self->registry = registry;
+    self->events = fk_event_queue_new(capacity);
+    g_mutex_init(&self->lock);
+    self->by_summary = g_hash_table_new(g_str_hash, g_str_equal);
+    self->by_id = g_hash_table_new_full(NULL, NULL, NULL, fk_crash_group_free);
+    self->device_handlers = g_hash_table_new_full(NULL, NULL, g_object_unref, NULL);
+
+    fk_invoke_sync(fk_crash_collector_begin, self);
+
+    return self;
+}
+
+void fk_crash_collector_free(FkCrashCollector *self) {
+    if (self == NULL)
+        return;
+    fk_invoke_sync(fk_crash_collector_end, self);
+    fk_event_queue_close(self->events);
+    fk_event_queue_free(self->events);
+    g_hash_table_unref(self->device_handlers);
+    g_hash_table_unref(self->by_summary);
+    g_hash_table_unref(self->by_id);
+    g_mutex_clear(&self->lock);
+    g_free(self);
+}
+
+FkEventQueue *fk_crash_collector_get_events(FkCrashCollector *self) {
+    return self->events;
+}
+
+static FridaCrash *fk_crash_collector_lookup(FkCrashCollector *self, guint id) {
+    g_mutex_lock(&self->lock);
+    FkCrashGroup *group = (FkCrashGroup *) g_hash_table_lookup(self->by_id, GUINT_TO_POINTER(id));
+    FridaCrash *crash = group != NULL ? (FridaCrash *) g_object_ref(group->first) : NULL;
+    g_mutex_unlock(&self->lock);
+    return crash;
+}
+
+GBytes *fk_crash_collector_get_report(FkCrashCollector *self, guint id) {
+    FridaCrash *crash = fk_crash_collector_lookup(self, id);
+    if (crash == NULL)
+        return NULL;
+    const gchar *report = frida_crash_get_report(crash);
+    GBytes *result = g_bytes_new(report, report != NULL ? strlen(report) : 0);
+    g_object_unref(crash);
+    return result;
+}
+
+GBytes *fk_crash_collector_get_parameters(FkCrashCollector *self, guint id) {
+    FridaCrash *crash = fk_crash_collector_lookup(self, id);
+    if (crash == NULL)
+        return NULL;
+    FkWriter writer;
+    fk_write_variant_dict(writer, frida_crash_get_parameters(crash));
+    g_object_unref(crash);
+    return writer.steal();
+}
+
+// Drops the group; the next crash with the same summary starts a new one.
+void fk_crash_collector_forget(FkCrashCollector *self, guint id) {
+    g_mutex_lock(&self->lock);
+    FkCrashGroup *group = (FkCrashGroup *) g_hash_table_lookup(self->by_id, GUINT_TO_POINTER(id));
+    if (group != NULL) {
+        g_hash_table_remove(self->by_summary, group->summary);
+        g_hash_table_remove(self->by_id, GUINT_TO_POINTER(id));
+    }
+    g_mutex_unlock(&self->lock);
+}
@@ -0,0 +1,37 @@
+#ifndef __FK_CRASH_COLLECTOR_H__
+#define __FK_CRASH_COLLECTOR_H__
+
+#include "frida_core.h"
+#include "fk_device_registry.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Follows process-crashed on every device in the registry, including ones
+// that show up later, and groups crashes by summary. Only the first crash of
+// a group is published in full; repeats just bump its count. Reports and
+// parameters stay native until asked for by crash id. Events:
+//   FK_CRASH_NEW:      u8 kind, u32 crash id, string device id, u32 pid,
+//                      string process name, string summary
+//   FK_CRASH_REPEATED: u8 kind, u32 crash id, string device id, u32 pid,
+//                      u32 count
+typedef struct _FkCrashCollector FkCrashCollector;
+
+typedef enum {
+    FK_CRASH_NEW,
+    FK_CRASH_REPEATED
+} FkCrashEvent;
+
+FkCrashCollector *fk_crash_collector_new(FkDeviceRegistry *registry, guint capacity);
+void fk_crash_collector_free(FkCrashCollector *self);
+
+FkEventQueue *fk_crash_collector_get_events(FkCrashCollector *self);
+// UTF-8 report text of the first crash in the group, or NULL if unknown.
+GBytes *fk_crash_collector_get_report(FkCrashCollector *self, guint id);
+// Parameters of that crash as a variant dict (see fk_marshal.h).
+GBytes *fk_crash_collector_get_parameters(FkCrashCollector *self, guint id);
+void fk_crash_collector_forget(FkCrashCollector *self, guint id);
+
+G_END_DECLS
+
+#endif
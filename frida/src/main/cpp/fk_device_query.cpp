@@ -0,0 +1,160 @@
+#include "fk_device_query.h"
+#include "fk_marshal.h"
+
+// The last process list seen for a device, kept as qdata on the device.
+struct FkProcessSnapshot {
+    FridaProcessList *list;
+    gint64 taken;
+};
+
+static GMutex fk_process_snapshot_lock;
+
+static G_DEFINE_QUARK(fk-process-snapshot, fk_process_snapshot)
+
+static void fk_process_snapshot_free(gpointer data) {
+    FkProcessSnapshot *snapshot = (FkProcessSnapshot *) data;
+    g_object_unref(snapshot->list);
+    g_free(snapshot);
+}
+
+static void fk_device_remember_processes(FridaDevice *device, FridaProcessList *list) {
+    FkProcessSnapshot *snapshot = g_new0(FkProcessSnapshot, 1);
+    snapshot->list = (FridaProcessList *) g_object_ref(list);
+    snapshot->taken = g_get_monotonic_time();
+
+    g_mutex_lock(&fk_process_snapshot_lock);
+    g_object_set_qdata_full(G_OBJECT(device), fk_process_snapshot_quark(), snapshot, fk_process_snapshot_free);
+    g_mutex_unlock(&fk_process_snapshot_lock);
+}
+
+static FridaProcessList *fk_device_recall_processes(FridaDevice *device, guint max_age_ms) {
+    FridaProcessList *list = NULL;
+
+    g_mutex_lock(&fk_process_snapshot_lock);
+    FkProcessSnapshot *snapshot =
+        (FkProcessSnapshot *) g_object_get_qdata(G_OBJECT(device), fk_process_snapshot_quark());
+    if (snapshot != NULL && g_get_monotonic_time() - snapshot->taken <= (gint64) max_age_ms * G_TIME_SPAN_MILLISECOND)
+        list = (FridaProcessList *) g_object_ref(snapshot->list);
+    g_mutex_unlock(&fk_process_snapshot_lock);
+
+    return list;
+}
+
+void fk_device_forget_processes(FridaDevice *device) {
+    g_mutex_lock(&fk_process_snapshot_lock);
+    g_object_set_qdata(G_OBJECT(device), fk_process_snapshot_quark(), NULL);
+    g_mutex_unlock(&fk_process_snapshot_lock);
+}
+
+static FridaProcess *fk_process_list_match(FridaProcessList *list, const gchar *name, guint pid) {
+    gchar *folded = name != NULL ? g_utf8_casefold(name, -1) : NULL;
+    FridaProcess *match = NULL;
+
+    gint size = frida_process_list_size(list);
+    for (gint i = 0; i != size && match == NULL; i++) {
+        FridaProcess *process = frida_process_list_get(list, i);
+        if (folded != NULL) {
+            gchar *candidate = g_utf8_casefold(frida_process_get_name(process), -1);
+            if (strcmp(candidate, folded) == 0)
+                match = (FridaProcess *) g_object_ref(process);
+            g_free(candidate);
+        } else if (frida_process_get_pid(process) == pid) {
+            match = (FridaProcess *) g_object_ref(process);
+        }
+        g_object_unref(process);
+    }
+
+    g_free(folded);
+    return match;
+}
+
+GBytes *fk_device_enumerate_applications(FridaDevice *device, FridaScope scope, const gchar *keys, GError **error) {
+    FridaApplicationQueryOptions *options = frida_application_query_options_new();
+    frida_application_query_options_set_scope(options, scope);
+    FridaApplicationList *list = frida_device_enumerate_applications_sync(device, options, NULL, error);
+    g_object_unref(options);
+    if (list == NULL)
+        return NULL;
+
+    gchar **selected = keys != NULL ? g_strsplit(keys, ",", -1) : NULL;
+    FkWriter writer;
+    fk_write_application_list_with_parameters(writer, list, selected);
+    g_strfreev(selected);
+    g_object_unref(list);
+
+    return writer.steal();
+}
+
+GBytes *fk_device_enumerate_processes(FridaDevice *device, FridaScope scope, const gchar *keys, GError **error) {
+    FridaProcessQueryOptions *options = frida_process_query_options_new();
+    frida_process_query_options_set_scope(options, scope);
+    FridaProcessList *list = frida_device_enumerate_processes_sync(device, options, NULL, error);
+    g_object_unref(options);
+    if (list == NULL)
+        return NULL;
+    fk_device_remember_processes(device, list);
+
+    gchar **selected = keys != NULL ? g_strsplit(keys, ",", -1) : NULL;
+    FkWriter writer;
+    fk_write_process_list_with_parameters(writer, list, selected);
+    g_strfreev(selected);
+    g_object_unref(list);
+
+    return writer.steal();
+}
+
+static FridaProcess *fk_device_query_process(FridaDevice *device, const gchar *name, guint pid, gint timeout_ms,
+                                             GError **error) {
+    if (timeout_ms == 0) {
+        FridaProcessQueryOptions *options = frida_process_query_options_new();
+        FridaProcessList *list = frida_device_enumerate_processes_sync(device, options, NULL, error);
+        g_object_unref(options);
+        if (list == NULL)
+            return NULL;
+        fk_device_remember_processes(device, list);
+
+        FridaProcess *process = fk_process_list_match(list, name, pid);
+        g_object_unref(list);
+        return process;
+    }
+
+    FridaProcessMatchOptions *options = frida_process_match_options_new();
+    frida_process_match_options_set_timeout(options, timeout_ms);
+    FridaProcess *process = name != NULL ? frida_device_find_process_by_name_sync(device, name, options, NULL, error)
+                                         : frida_device_find_process_by_pid_sync(device, pid, options, NULL, error);
+    g_object_unref(options);
+
+    // It appeared after the snapshot was taken.
+    if (process != NULL)
+        fk_device_forget_processes(device);
+    return process;
+}
+
+GBytes *fk_device_find_process(FridaDevice *device, const gchar *name, guint pid, gint timeout_ms, guint max_age_ms,
+                               GError **error) {
+    FridaProcess *process = NULL;
+
+    FridaProcessList *cached = fk_device_recall_processes(device, max_age_ms);
+    if (cached != NULL) {
+        process = fk_process_list_match(cached, name, pid);
+        g_object_unref(cached);
+    }
+
+    if (process == NULL) {
+        GError *local_error = NULL;
+        process = fk_device_query_process(device, name, pid, timeout_ms, &local_error);
+        if (local_error != NULL) {
+            g_propagate_error(error, local_error);
+            return NULL;
+        }
+    }
+
+    FkWriter writer;
+    writer.put_u32(process != NULL ? 1 : 0);
+    if (process != NULL) {
+        writer.put_u32(frida_process_get_pid(process));
+        writer.put_string(frida_process_get_name(process));
+        g_object_unref(process);
+    }
+    return writer.steal();
+}
@@ -0,0 +1,27 @@
+#ifndef __FK_DEVICE_QUERY_H__
+#define __FK_DEVICE_QUERY_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Application and process enumeration with parameters, encoded in a single
+// buffer per list (see fk_marshal.h). keys is a comma-separated selection of
+// parameters to keep, NULL for all of them, or empty for none.
+GBytes *fk_device_enumerate_applications(FridaDevice *device, FridaScope scope, const gchar *keys, GError **error);
+GBytes *fk_device_enumerate_processes(FridaDevice *device, FridaScope scope, const gchar *keys, GError **error);
+
+// Looks a process up by name (case-insensitively) or, when name is NULL, by
+// pid, and returns a process list of zero or one entries. The device's last
+// process enumeration is consulted first if it is at most max_age_ms old;
+// otherwise, or if it has no match, the device is asked. With timeout_ms 0
+// that is one enumeration, which also refreshes the snapshot; otherwise frida
+// waits on its event loop for the process to appear, up to timeout_ms (-1 for
+// no limit).
+GBytes *fk_device_find_process(FridaDevice *device, const gchar *name, guint pid, gint timeout_ms, guint max_age_ms,
+                               GError **error);
+void fk_device_forget_processes(FridaDevice *device);
+
+G_END_DECLS
+
+#endif
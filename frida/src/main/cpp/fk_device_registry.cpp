@@ -0,0 +1,223 @@
+#include "fk_device_registry.h"
+#include "fk_main_context.h"
+#include "fk_marshal.h"
+
+struct _FkDeviceRegistry {
+    FridaDeviceManager *manager;
+    GMutex lock;
+    GHashTable *devices;
+    FkEventQueue *changes;
+    GHashTable *system_parameters;
+    guint64 generation;
+    gulong added_handler;
+    gulong removed_handler;
+    gulong changed_handler;
+};
+
+static void fk_device_registry_write(FkWriter &writer, FridaDevice *device) {
+    writer.put_string(frida_device_get_id(device));
+    writer.put_string(frida_device_get_name(device));
+    writer.put_u32((guint32) frida_device_get_dtype(device));
+}
+
+static void fk_device_registry_publish(FkDeviceRegistry *self, FkDeviceChange kind, FridaDevice *device) {
+    FkWriter writer;
+    writer.put_u8((guint8) kind);
+    fk_device_registry_write(writer, device);
+    fk_event_queue_push(self->changes, writer.data(), writer.size());
+}
+
+static gboolean fk_device_registry_insert(FkDeviceRegistry *self, FridaDevice *device) {
+    const gchar *id = frida_device_get_id(device);
+
+    g_mutex_lock(&self->lock);
+    gboolean is_new = g_hash_table_lookup(self->devices, id) != device;
+    if (is_new)
+        g_hash_table_replace(self->devices, g_strdup(id), g_object_ref(device));
+    g_mutex_unlock(&self->lock);
+
+    return is_new;
+}
+
+static void fk_device_registry_on_added(FridaDeviceManager *manager, FridaDevice *device, gpointer user_data) {
+    FkDeviceRegistry *self = (FkDeviceRegistry *) user_data;
+
+    if (fk_device_registry_insert(self, device))
+        fk_device_registry_publish(self, FK_DEVICE_ADDED, device);
+}
+
+static void fk_device_registry_on_removed(FridaDeviceManager *manager, FridaDevice *device, gpointer user_data) {
+    FkDeviceRegistry *self = (FkDeviceRegistry *) user_data;
+
+    gpointer key = NULL;
+    gpointer value = NULL;
+
+    g_mutex_lock(&self->lock);
+    gboolean removed = g_hash_table_lookup(self->devices, frida_device_get_id(device)) == device &&
+        g_hash_table_steal_extended(self->devices, frida_device_get_id(device), &key, &value);
+    if (removed) {
+        self->generation++;
+        g_hash_table_remove(self->system_parameters, key);
+    }
+    g_mutex_unlock(&self->lock);
+
+    if (removed) {
+        fk_device_registry_publish(self, FK_DEVICE_REMOVED, device);
+        g_free(key);
+        g_object_unref(value);
+    }
+}
+
+static void fk_device_registry_on_changed(FridaDeviceManager *manager, gpointer user_data) {
+    fk_device_registry_invalidate((FkDeviceRegistry *) user_data);
+}
+
+FkDeviceRegistry *fk_device_registry_new(FridaDeviceManager *manager) {
+    FkDeviceRegistry *self = g_new0(FkDeviceRegistry, 1);
+    self->manager = (FridaDeviceManager *) g_object_ref(manager);
+    g_mutex_init(&self->lock);
+    self->devices = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+    self->changes = fk_event_queue_new(0);
+    self->system_parameters = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_bytes_unref);
+
+    // Connect before seeding so nothing slips through between the two; a
+    // device reported by both paths is only inserted once.
+    self->added_handler = g_signal_connect(manager, "added", G_CALLBACK(fk_device_registry_on_added), self);
+    self->removed_handler = g_signal_connect(manager, "removed", G_CALLBACK(fk_device_registry_on_removed), self);
+    self->changed_handler = g_signal_connect(manager, "changed", G_CALLBACK(fk_device_registry_on_changed), self);
+
+    FridaDeviceList *list = frida_device_manager_enumerate_devices_sync(manager, NULL, NULL);
+    if (list != NULL) {
+        gint size = frida_device_list_size(list);
+        for (gint i = 0; i != size; i++) {
+            FridaDevice *device = frida_device_list_get(list, i);
+            fk_device_registry_insert(self, device);
+            g_object_unref(device);
+        }
+        frida_unref(list);
+    }
+
+    return self;
+}
+
+// Runs on the frida main context, so no handler is still running with self
+// once this returns.
+static void fk_device_registry_teardown(gpointer user_data) {
+    FkDeviceRegistry *self = (FkDeviceRegistry *) user_data;
+    g_signal_handler_disconnect(self->manager, self->added_handler);
+    g_signal_handler_disconnect(self->manager, self->removed_handler);
+    g_signal_handler_disconnect(self->manager, self->changed_handler);
+}
+
+void fk_device_registry_free(FkDeviceRegistry *self) {
+    if (self == NULL)
+        return;
+    fk_invoke_sync(fk_device_registry_teardown, self);
+    fk_event_queue_close(self->changes);
+    fk_event_queue_free(self->changes);
+    g_hash_table_unref(self->system_parameters);
+    g_hash_table_unref(self->devices);
+    g_mutex_clear(&self->lock);
+    g_object_unref(self->manager);
+    g_free(self);
+}
+
+FridaDeviceManager *fk_device_registry_get_manager(FkDeviceRegistry *self) {
+    return self->manager;
+}
+
+// Returns a new reference, or NULL if no such device is currently attached.
+FridaDevice *fk_device_registry_lookup(FkDeviceRegistry *self, const gchar *id) {
+    g_mutex_lock(&self->lock);
+    FridaDevice *device = (FridaDevice *) g_hash_table_lookup(self->devices, id);
+    if (device != NULL)
+        g_object_ref(device);
+    g_mutex_unlock(&self->lock);
+    return device;
+}
+
+// Full membership as: u32 count, then count x (string id, string name, u32 type).
+GBytes *fk_device_registry_snapshot(FkDeviceRegistry *self) {
+    FkWriter writer;
+
+    g_mutex_lock(&self->lock);
+    writer.put_u32(g_hash_table_size(self->devices));
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, self->devices);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        fk_device_registry_write(writer, (FridaDevice *) value);
+    g_mutex_unlock(&self->lock);
+
+    return writer.steal();
+}
+
+// Every registered device as a new reference; the array owns them.
+GPtrArray *fk_device_registry_list(FkDeviceRegistry *self) {
+    GPtrArray *result = g_ptr_array_new_with_free_func(g_object_unref);
+
+    g_mutex_lock(&self->lock);
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, self->devices);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+        g_ptr_array_add(result, g_object_ref(value));
+    g_mutex_unlock(&self->lock);
+
+    return result;
+}
+
+// System parameters as a variant dict (see fk_marshal.h), queried once per
+// device and served from the cache until the device goes away, the manager
+// reports a change, or the cache is invalidated explicitly.
+GBytes *fk_device_registry_query_system_parameters(FkDeviceRegistry *self, const gchar *id, GError **error) {
+    g_mutex_lock(&self->lock);
+    GBytes *cached = (GBytes *) g_hash_table_lookup(self->system_parameters, id);
+    if (cached != NULL)
+        g_bytes_ref(cached);
+    guint64 generation = self->generation;
+    g_mutex_unlock(&self->lock);
+
+    if (cached != NULL)
+        return cached;
+
+    FridaDevice *device = fk_device_registry_lookup(self, id);
+    if (device == NULL) {
+        g_set_error(error, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT, "No such device: %s", id);
+        return NULL;
+    }
+
+    GHashTable *parameters = frida_device_query_system_parameters_sync(device, NULL, error);
+    g_object_unref(device);
+    if (parameters == NULL)
+        return NULL;
+
+    FkWriter writer;
+    fk_write_variant_dict(writer, parameters);
+    g_hash_table_unref(parameters);
+    GBytes *result = writer.steal();
+
+    // Skip caching if an invalidation raced with the query.
+    g_mutex_lock(&self->lock);
+    if (self->generation == generation)
+        g_hash_table_replace(self->system_parameters, g_strdup(id), g_bytes_ref(result));
+    g_mutex_unlock(&self->lock);
+
+    return result;
+}
+
+void fk_device_registry_invalidate(FkDeviceRegistry *self) {
+    g_mutex_lock(&self->lock);
+    self->generation++;
+    g_hash_table_remove_all(self->system_parameters);
+    g_mutex_unlock(&self->lock);
+}
+
+FkEventQueue *fk_device_registry_get_changes(FkDeviceRegistry *self) {
+    return self->changes;
+}
+
+void fk_device_unref(FridaDevice *device) {
+    if (device != NULL)
+        g_object_unref(device);
+}
@@ -0,0 +1,35 @@
+#ifndef __FK_DEVICE_REGISTRY_H__
+#define __FK_DEVICE_REGISTRY_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Keeps a ref on every FridaDevice the manager knows about, keyed by id, and
+// follows the manager's added/removed signals so lookups never leave the
+// process. Membership changes are published as records on the change queue:
+//   u8 kind (FK_DEVICE_ADDED | FK_DEVICE_REMOVED), string id, string name, u32 type
+typedef struct _FkDeviceRegistry FkDeviceRegistry;
+
+typedef enum {
+    FK_DEVICE_ADDED,
+    FK_DEVICE_REMOVED
+} FkDeviceChange;
+
+FkDeviceRegistry *fk_device_registry_new(FridaDeviceManager *manager);
+void fk_device_registry_free(FkDeviceRegistry *self);
+
+FridaDeviceManager *fk_device_registry_get_manager(FkDeviceRegistry *self);
+FridaDevice *fk_device_registry_lookup(FkDeviceRegistry *self, const gchar *id);
+GBytes *fk_device_registry_snapshot(FkDeviceRegistry *self);
+GPtrArray *fk_device_registry_list(FkDeviceRegistry *self);
+FkEventQueue *fk_device_registry_get_changes(FkDeviceRegistry *self);
+GBytes *fk_device_registry_query_system_parameters(FkDeviceRegistry *self, const gchar *id, GError **error);
+void fk_device_registry_invalidate(FkDeviceRegistry *self);
+
+void fk_device_unref(FridaDevice *device);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,43 @@
+#include "fk_endpoint.h"
+
+GTlsCertificate *fk_tls_certificate_parse(const gchar *certificate, GError **error) {
+    if (g_str_has_prefix(certificate, "-----BEGIN"))
+        return g_tls_certificate_new_from_pem(certificate, -1, error);
+    return g_tls_certificate_new_from_file(certificate, error);
+}
+
+FridaEndpointParameters *fk_endpoint_parameters_new(const gchar *address, guint16 port, const gchar *certificate,
+                                                    const gchar *origin, const gchar *token,
+                                                    FkAuthService *auth_service, const gchar *asset_root,
+                                                    GError **error) {
+    if (asset_root != NULL && !g_file_test(asset_root, G_FILE_TEST_IS_DIR)) {
+        g_set_error(error, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT, "Asset root is not a directory: %s", asset_root);
+        return NULL;
+    }
+
+    GTlsCertificate *tls = NULL;
+    if (certificate != NULL) {
+        tls = fk_tls_certificate_parse(certificate, error);
+        if (tls == NULL)
+            return NULL;
+    }
+
+    FridaAuthenticationService *auth = NULL;
+    if (auth_service != NULL)
+        auth = (FridaAuthenticationService *) g_object_ref(auth_service);
+    else if (token != NULL && token[0] != '\0')
+        auth = (FridaAuthenticationService *) frida_static_authentication_service_new(token);
+
+    GFile *assets = asset_root != NULL ? g_file_new_for_path(asset_root) : NULL;
+
+    FridaEndpointParameters *params = frida_endpoint_parameters_new(address, port, tls, origin, auth, assets);
+
+    if (assets != NULL)
+        g_object_unref(assets);
+    if (auth != NULL)
+        g_object_unref(auth);
+    if (tls != NULL)
+        g_object_unref(tls);
+
+    return params;
+}
@@ -0,0 +1,23 @@
+#ifndef __FK_ENDPOINT_H__
+#define __FK_ENDPOINT_H__
+
+#include "frida_core.h"
+#include "fk_auth_service.h"
+
+G_BEGIN_DECLS
+
+// Endpoint parameters for services hosted by the binding. Tokens are checked
+// by auth_service when given, else against token; with neither (or an empty
+// token) authentication is disabled. A certificate may be a PEM string or a
+// file path. asset_root, when given, must be a directory; frida-core serves
+// its files over HTTP on the same port.
+FridaEndpointParameters *fk_endpoint_parameters_new(const gchar *address, guint16 port, const gchar *certificate,
+                                                    const gchar *origin, const gchar *token,
+                                                    FkAuthService *auth_service, const gchar *asset_root,
+                                                    GError **error);
+
+GTlsCertificate *fk_tls_certificate_parse(const gchar *certificate, GError **error);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,106 @@
+#include "fk_event_queue.h"
+#include "fk_writer.h"
+
+struct _FkEventQueue {
+    GMutex lock;
+    GCond cond;
+    GByteArray *records;
+    guint count;
+    guint dropped;
+    guint capacity;
+    gboolean closed;
+};
+
+FkEventQueue *fk_event_queue_new(guint capacity) {
+    FkEventQueue *self = g_new0(FkEventQueue, 1);
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+    self->records = g_byte_array_new();
+    self->capacity = capacity;
+    return self;
+}
+
+void fk_event_queue_free(FkEventQueue *self) {
+    if (self == NULL)
+        return;
+    g_byte_array_unref(self->records);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+    g_free(self);
+}
+
+// Records that would grow the queue past its capacity (in bytes) are counted
+// as dropped instead of buffered; a capacity of 0 means unbounded.
+gboolean fk_event_queue_push(FkEventQueue *self, const guint8 *record, gsize size) {
+    g_mutex_lock(&self->lock);
+
+    if (self->closed || (self->capacity != 0 && self->records->len + size + 4 > self->capacity)) {
+        self->dropped++;
+        g_mutex_unlock(&self->lock);
+        return FALSE;
+    }
+
+    guint32 le = GUINT32_TO_LE((guint32) size);
+    g_byte_array_append(self->records, (const guint8 *) &le, sizeof(le));
+    g_byte_array_append(self->records, record, (guint) size);
+    self->count++;
+
+    g_cond_signal(&self->cond);
+    g_mutex_unlock(&self->lock);
+    return TRUE;
+}
+
+// Blocks for up to timeout_ms (forever when negative) until something is
+// pending, then hands back every buffered record. Returns NULL on timeout or
+// once the queue is closed and empty.
+GBytes *fk_event_queue_drain(FkEventQueue *self, gint timeout_ms) {
+    g_mutex_lock(&self->lock);
+
+    gint64 deadline = timeout_ms > 0 ? g_get_monotonic_time() + (gint64) timeout_ms * G_TIME_SPAN_MILLISECOND : 0;
+    while (self->count == 0 && self->dropped == 0 && !self->closed && timeout_ms != 0) {
+        if (timeout_ms < 0) {
+            g_cond_wait(&self->cond, &self->lock);
+        } else if (!g_cond_wait_until(&self->cond, &self->lock, deadline)) {
+            break;
+        }
+    }
+
+    if (self->count == 0 && self->dropped == 0) {
+        g_mutex_unlock(&self->lock);
+        return NULL;
+    }
+
+    FkWriter header;
+    header.put_u32(self->count);
+    header.put_u32(self->dropped);
+    g_byte_array_prepend(self->records, header.data(), (guint) header.size());
+
+    GBytes *batch = g_byte_array_free_to_bytes(self->records);
+    self->records = g_byte_array_new();
+    self->count = 0;
+    self->dropped = 0;
+
+    g_mutex_unlock(&self->lock);
+    return batch;
+}
+
+guint fk_event_queue_pending(FkEventQueue *self) {
+    g_mutex_lock(&self->lock);
+    guint count = self->count;
+    g_mutex_unlock(&self->lock);
+    return count;
+}
+
+void fk_event_queue_close(FkEventQueue *self) {
+    g_mutex_lock(&self->lock);
+    self->closed = TRUE;
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+}
+
+gboolean fk_event_queue_is_closed(FkEventQueue *self) {
+    g_mutex_lock(&self->lock);
+    gboolean closed = self->closed;
+    g_mutex_unlock(&self->lock);
+    return closed;
+}
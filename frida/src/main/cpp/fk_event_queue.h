@@ -0,0 +1,26 @@
+#ifndef __FK_EVENT_QUEUE_H__
+#define __FK_EVENT_QUEUE_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Thread-safe queue of serialized records. Producers push from the frida main
+// context; Kotlin drains everything pending in one call, so a burst of signals
+// costs a single JNI crossing.
+//
+// A drained batch is: u32 count, u32 dropped, then count x (u32 size, payload).
+typedef struct _FkEventQueue FkEventQueue;
+
+FkEventQueue *fk_event_queue_new(guint capacity);
+void fk_event_queue_free(FkEventQueue *self);
+
+gboolean fk_event_queue_push(FkEventQueue *self, const guint8 *record, gsize size);
+GBytes *fk_event_queue_drain(FkEventQueue *self, gint timeout_ms);
+guint fk_event_queue_pending(FkEventQueue *self);
+void fk_event_queue_close(FkEventQueue *self);
+gboolean fk_event_queue_is_closed(FkEventQueue *self);
+
+G_END_DECLS
+
+#endif
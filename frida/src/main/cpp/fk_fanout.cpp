@@ -0,0 +1,205 @@
+#include "fk_fanout.h"
+#include "fk_marshal.h"
+
+struct FkFanOutJob;
+
+struct FkFanOutSlot {
+    FkFanOutJob *job;
+    FridaDevice *device;
+    GCancellable *cancellable;
+    GSource *timeout;
+    gboolean done;
+    FkFanOutStatus status;
+    GBytes *payload;
+    gchar *error;
+};
+
+struct FkFanOutJob {
+    volatile gint ref_count;
+    GMutex lock;
+    GCond cond;
+    guint pending;
+    FkFanOutQuery query;
+    FridaScope scope;
+    gint timeout_ms;
+    FkFanOutSlot *slots;
+    guint n_slots;
+};
+
+static void fk_fanout_job_unref(FkFanOutJob *job) {
+    if (!g_atomic_int_dec_and_test(&job->ref_count))
+        return;
+
+    for (guint i = 0; i != job->n_slots; i++) {
+        FkFanOutSlot *slot = &job->slots[i];
+        g_object_unref(slot->device);
+        g_object_unref(slot->cancellable);
+        if (slot->payload != NULL)
+            g_bytes_unref(slot->payload);
+        g_free(slot->error);
+    }
+    g_free(job->slots);
+    g_cond_clear(&job->cond);
+    g_mutex_clear(&job->lock);
+    g_free(job);
+}
+
+// First outcome wins: a reply that arrives after its slot timed out is dropped.
+static void fk_fanout_complete(FkFanOutSlot *slot, FkFanOutStatus status, GBytes *payload, const gchar *error) {
+    FkFanOutJob *job = slot->job;
+
+    g_mutex_lock(&job->lock);
+    if (!slot->done) {
+        slot->done = TRUE;
+        slot->status = status;
+        slot->payload = payload;
+        slot->error = g_strdup(error);
+        payload = NULL;
+        job->pending--;
+        g_cond_broadcast(&job->cond);
+    }
+    g_mutex_unlock(&job->lock);
+
+    if (payload != NULL)
+        g_bytes_unref(payload);
+}
+
+static void fk_fanout_on_reply(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkFanOutSlot *slot = (FkFanOutSlot *) user_data;
+    FridaDevice *device = (FridaDevice *) source;
+    GError *error = NULL;
+    FkWriter writer;
+    gboolean ok = FALSE;
+
+    switch (slot->job->query) {
+        case FK_FANOUT_ENUMERATE_APPLICATIONS: {
+            FridaApplicationList *list = frida_device_enumerate_applications_finish(device, result, &error);
+            if (list != NULL) {
+                fk_write_application_list(writer, list);
+                frida_unref(list);
+                ok = TRUE;
+            }
+            break;
+        }
+        case FK_FANOUT_ENUMERATE_PROCESSES: {
+            FridaProcessList *list = frida_device_enumerate_processes_finish(device, result, &error);
+            if (list != NULL) {
+                fk_write_process_list(writer, list);
+                frida_unref(list);
+                ok = TRUE;
+            }
+            break;
+        }
+    }
+
+    if (ok)
+        fk_fanout_complete(slot, FK_FANOUT_OK, writer.steal(), NULL);
+    else
+        fk_fanout_complete(slot, FK_FANOUT_FAILED, NULL, error != NULL ? error->message : "Unknown error");
+    g_clear_error(&error);
+
+    if (slot->timeout != NULL) {
+        g_source_destroy(slot->timeout);
+        g_source_unref(slot->timeout);
+        slot->timeout = NULL;
+    }
+
+    fk_fanout_job_unref(slot->job);
+}
+
+static gboolean fk_fanout_on_timeout(gpointer user_data) {
+    FkFanOutSlot *slot = (FkFanOutSlot *) user_data;
+
+    fk_fanout_complete(slot, FK_FANOUT_TIMED_OUT, NULL, "Timed out");
+    g_cancellable_cancel(slot->cancellable);
+
+    g_source_unref(slot->timeout);
+    slot->timeout = NULL;
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean fk_fanout_start(gpointer user_data) {
+    FkFanOutJob *job = (FkFanOutJob *) user_data;
+    GMainContext *context = frida_get_main_context();
+
+    FridaApplicationQueryOptions *application_options = frida_application_query_options_new();
+    frida_application_query_options_set_scope(application_options, job->scope);
+    FridaProcessQueryOptions *process_options = frida_process_query_options_new();
+    frida_process_query_options_set_scope(process_options, job->scope);
+
+    for (guint i = 0; i != job->n_slots; i++) {
+        FkFanOutSlot *slot = &job->slots[i];
+
+        if (job->timeout_ms > 0) {
+            slot->timeout = g_timeout_source_new((guint) job->timeout_ms);
+            g_source_set_callback(slot->timeout, fk_fanout_on_timeout, slot, NULL);
+            g_source_attach(slot->timeout, context);
+        }
+
+        switch (job->query) {
+            case FK_FANOUT_ENUMERATE_APPLICATIONS:
+                frida_device_enumerate_applications(slot->device, application_options, slot->cancellable,
+                                                    fk_fanout_on_reply, slot);
+                break;
+            case FK_FANOUT_ENUMERATE_PROCESSES:
+                frida_device_enumerate_processes(slot->device, process_options, slot->cancellable,
+                                                 fk_fanout_on_reply, slot);
+                break;
+        }
+    }
+
+    g_object_unref(application_options);
+    g_object_unref(process_options);
+    return G_SOURCE_REMOVE;
+}
+
+GBytes *fk_fanout_run(FkDeviceRegistry *registry, FkFanOutQuery query, FridaScope scope, gint timeout_ms) {
+    GPtrArray *devices = fk_device_registry_list(registry);
+
+    FkFanOutJob *job = g_new0(FkFanOutJob, 1);
+    g_mutex_init(&job->lock);
+    g_cond_init(&job->cond);
+    job->query = query;
+    job->scope = scope;
+    job->timeout_ms = timeout_ms;
+    job->n_slots = devices->len;
+    job->pending = devices->len;
+    job->slots = g_new0(FkFanOutSlot, devices->len);
+    // One ref for the caller plus one per in-flight request.
+    job->ref_count = 1 + (gint) devices->len;
+
+    for (guint i = 0; i != devices->len; i++) {
+        FkFanOutSlot *slot = &job->slots[i];
+        slot->job = job;
+        slot->device = (FridaDevice *) g_object_ref(g_ptr_array_index(devices, i));
+        slot->cancellable = g_cancellable_new();
+    }
+    g_ptr_array_unref(devices);
+
+    if (job->n_slots != 0) {
+        GSource *source = g_idle_source_new();
+        g_source_set_callback(source, fk_fanout_start, job, NULL);
+        g_source_attach(source, frida_get_main_context());
+        g_source_unref(source);
+    }
+
+    g_mutex_lock(&job->lock);
+    while (job->pending != 0)
+        g_cond_wait(&job->cond, &job->lock);
+    g_mutex_unlock(&job->lock);
+
+    FkWriter writer;
+    writer.put_u32(job->n_slots);
+    for (guint i = 0; i != job->n_slots; i++) {
+        FkFanOutSlot *slot = &job->slots[i];
+        writer.put_string(frida_device_get_id(slot->device));
+        writer.put_u8((guint8) slot->status);
+        if (slot->status == FK_FANOUT_OK)
+            writer.put_gbytes(slot->payload);
+        else
+            writer.put_string(slot->error);
+    }
+
+    fk_fanout_job_unref(job);
+    return writer.steal();
+}
@@ -0,0 +1,31 @@
+#ifndef __FK_FANOUT_H__
+#define __FK_FANOUT_H__
+
+#include "frida_core.h"
+#include "fk_device_registry.h"
+
+G_BEGIN_DECLS
+
+// Runs one query against every registered device at once. All async calls are
+// issued from a single idle callback on the frida main context, so the total
+// latency is that of the slowest device (bounded by timeout_ms) rather than
+// the sum. Must not be called from the frida main context itself.
+//
+// Result: u32 count, then count x (string device id, u8 FkFanOutStatus, and
+// either the query payload as a length-prefixed blob or a string error).
+typedef enum {
+    FK_FANOUT_ENUMERATE_APPLICATIONS,
+    FK_FANOUT_ENUMERATE_PROCESSES
+} FkFanOutQuery;
+
+typedef enum {
+    FK_FANOUT_OK,
+    FK_FANOUT_FAILED,
+    FK_FANOUT_TIMED_OUT
+} FkFanOutStatus;
+
+GBytes *fk_fanout_run(FkDeviceRegistry *registry, FkFanOutQuery query, FridaScope scope, gint timeout_ms);
+
+G_END_DECLS
+
+#endif
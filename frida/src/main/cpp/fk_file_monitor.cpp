@@ -0,0 +1,129 @@
+#include "fk_file_monitor.h"
+#include "fk_main_context.h"
+#include "fk_writer.h"
+
+struct FkFileChange {
+    gchar *path;
+    gchar *other_path;
+    GFileMonitorEvent event;
+    guint merged;
+};
+
+// The pending window is only touched from the main context: by the change
+// handler, the flush source and teardown.
+struct _FkFileMonitor {
+    FridaFileMonitor *monitor;
+    FkEventQueue *events;
+    guint coalesce_ms;
+    GHashTable *pending;
+    GQueue order;
+    GSource *flush;
+    gulong change_handler;
+};
+
+static void fk_file_change_free(gpointer data) {
+    FkFileChange *change = (FkFileChange *) data;
+    g_free(change->path);
+    g_free(change->other_path);
+    g_free(change);
+}
+
+static gboolean fk_file_monitor_flush(gpointer user_data) {
+    FkFileMonitor *self = (FkFileMonitor *) user_data;
+
+    FkWriter writer;
+    writer.put_u32(g_queue_get_length(&self->order));
+    FkFileChange *change;
+    while ((change = (FkFileChange *) g_queue_pop_head(&self->order)) != NULL) {
+        writer.put_u8(change->event);
+        writer.put_string(change->path);
+        writer.put_string(change->other_path);
+        writer.put_u32(change->merged);
+    }
+    g_hash_table_remove_all(self->pending);
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+
+    g_source_unref(self->flush);
+    self->flush = NULL;
+    return G_SOURCE_REMOVE;
+}
+
+static void fk_file_monitor_on_change(FridaFileMonitor *monitor, const gchar *path, const gchar *other_path,
+                                      GFileMonitorEvent event, gpointer user_data) {
+    FkFileMonitor *self = (FkFileMonitor *) user_data;
+
+    FkFileChange *change = (FkFileChange *) g_hash_table_lookup(self->pending, path);
+    if (change == NULL) {
+        change = g_new0(FkFileChange, 1);
+        change->path = g_strdup(path);
+        g_hash_table_insert(self->pending, change->path, change);
+        g_queue_push_tail(&self->order, change);
+    }
+    g_free(change->other_path);
+    change->other_path = g_strdup(other_path);
+    change->event = event;
+    change->merged++;
+
+    if (self->flush == NULL)
+        self->flush = fk_schedule(self->coalesce_ms, fk_file_monitor_flush, self, NULL);
+}
+
+static void fk_file_monitor_connect(gpointer user_data) {
+    FkFileMonitor *self = (FkFileMonitor *) user_data;
+    if (self->change_handler != 0)
+        return;
+    self->change_handler = g_signal_connect(self->monitor, "change", G_CALLBACK(fk_file_monitor_on_change), self);
+}
+
+static void fk_file_monitor_teardown(gpointer user_data) {
+    FkFileMonitor *self = (FkFileMonitor *) user_data;
+
+    if (self->change_handler != 0) {
+        g_signal_handler_disconnect(self->monitor, self->change_handler);
+        self->change_handler = 0;
+    }
+
+    if (self->flush != NULL) {
+        g_source_destroy(self->flush);
+        g_source_unref(self->flush);
+        self->flush = NULL;
+    }
+    g_queue_clear(&self->order);
+    g_hash_table_remove_all(self->pending);
+}
+
+FkFileMonitor *fk_file_monitor_new(const gchar *path, guint coalesce_ms, guint capacity) {
+    FkFileMonitor *self = g_new0(FkFileMonitor, 1);
+    self->monitor = frida_file_monitor_new(path);
+    self->events = fk_event_queue_new(capacity);
+    self->coalesce_ms = coalesce_ms;
+    self->pending = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, fk_file_change_free);
+    g_queue_init(&self->order);
+    return self;
+}
+
+void fk_file_monitor_free(FkFileMonitor *self) {
+    if (self == NULL)
+        return;
+    fk_invoke_sync(fk_file_monitor_teardown, self);
+    frida_file_monitor_disable_sync(self->monitor, NULL, NULL);
+    fk_event_queue_close(self->events);
+    fk_event_queue_free(self->events);
+    g_hash_table_unref(self->pending);
+    g_object_unref(self->monitor);
+    g_free(self);
+}
+
+void fk_file_monitor_enable_sync(FkFileMonitor *self, GError **error) {
+    fk_invoke_sync(fk_file_monitor_connect, self);
+    frida_file_monitor_enable_sync(self->monitor, NULL, error);
+}
+
+// Changes already pending are still delivered when their window closes.
+void fk_file_monitor_disable_sync(FkFileMonitor *self, GError **error) {
+    frida_file_monitor_disable_sync(self->monitor, NULL, error);
+}
+
+FkEventQueue *fk_file_monitor_get_events(FkFileMonitor *self) {
+    return self->events;
+}
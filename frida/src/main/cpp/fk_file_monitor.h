@@ -0,0 +1,25 @@
+#ifndef __FK_FILE_MONITOR_H__
+#define __FK_FILE_MONITOR_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Watches a local path through FridaFileMonitor. Changes are coalesced by
+// path: the first change opens a window of coalesce_ms, and every change seen
+// until it closes is merged into its path's entry, which keeps the latest
+// event. Each window is published as a single record:
+//   u32 count x (u8 GFileMonitorEvent, string path, string other path, u32 merged)
+typedef struct _FkFileMonitor FkFileMonitor;
+
+FkFileMonitor *fk_file_monitor_new(const gchar *path, guint coalesce_ms, guint capacity);
+void fk_file_monitor_free(FkFileMonitor *self);
+
+void fk_file_monitor_enable_sync(FkFileMonitor *self, GError **error);
+void fk_file_monitor_disable_sync(FkFileMonitor *self, GError **error);
+FkEventQueue *fk_file_monitor_get_events(FkFileMonitor *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,351 @@
+#include "fk_forwarder.h"
+#include "fk_main_context.h"
+#include "fk_writer.h"
+
+#ifdef G_OS_WIN32
+# include <winsock2.h>
+#else
+# include <netinet/in.h>
+# include <netinet/tcp.h>
+#endif
+
+#define FK_FORWARDER_CHUNK_SIZE (64 * 1024)
+
+struct FkForwarderStats {
+    gint64 accepted;
+    gint64 active;
+    gint64 failed;
+    gint64 bytes_to_device;
+    gint64 bytes_from_device;
+    gint64 open_us_total;
+    gint64 open_us_max;
+    gint64 chunks;
+    gint64 chunk_us_total;
+    gint64 chunk_us_max;
+};
+
+struct _FkForwarder {
+    volatile gint ref_count;
+    FridaDevice *device;
+    gchar *remote_address;
+    GSocketService *service;
+    guint16 port;
+    GHashTable *connections;
+    gulong incoming_handler;
+
+    GMutex lock;
+    FkForwarderStats stats;
+};
+
+struct FkForwardedConnection;
+
+struct FkPump {
+    FkForwardedConnection *connection;
+    GInputStream *input;
+    GIOStream *to;
+    GOutputStream *output;
+    gboolean to_device;
+    gint64 read_at;
+    guint8 buffer[FK_FORWARDER_CHUNK_SIZE];
+};
+
+struct FkForwardedConnection {
+    volatile gint ref_count;
+    FkForwarder *forwarder;
+    GIOStream *local;
+    GIOStream *remote;
+    GCancellable *cancellable;
+    gint64 accepted_at;
+    guint pumps_ended;
+    FkPump upstream;
+    FkPump downstream;
+};
+
+static FkForwarder *fk_forwarder_ref(FkForwarder *self) {
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+static void fk_forwarder_unref(FkForwarder *self) {
+    if (!g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+    g_hash_table_unref(self->connections);
+    g_mutex_clear(&self->lock);
+    g_free(self->remote_address);
+    g_object_unref(self->device);
+    g_free(self);
+}
+
+static FkForwardedConnection *fk_forwarded_connection_ref(FkForwardedConnection *connection) {
+    g_atomic_int_inc(&connection->ref_count);
+    return connection;
+}
+
+static void fk_forwarded_connection_unref(FkForwardedConnection *connection) {
+    if (!g_atomic_int_dec_and_test(&connection->ref_count))
+        return;
+
+    FkForwarder *forwarder = connection->forwarder;
+    g_mutex_lock(&forwarder->lock);
+    forwarder->stats.active--;
+    g_mutex_unlock(&forwarder->lock);
+
+    g_io_stream_close_async(connection->local, G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+    g_object_unref(connection->local);
+    if (connection->remote != NULL) {
+        g_io_stream_close_async(connection->remote, G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+        g_object_unref(connection->remote);
+    }
+    g_object_unref(connection->cancellable);
+    fk_forwarder_unref(forwarder);
+    g_free(connection);
+}
+
+// Either side failing, or both having ended, takes the whole connection down.
+static void fk_forwarded_connection_shutdown(FkForwardedConnection *connection) {
+    g_cancellable_cancel(connection->cancellable);
+    g_hash_table_remove(connection->forwarder->connections, connection);
+}
+
+static void fk_pump_read(FkPump *pump);
+
+// EOF on one side only half-closes the other: its peer may still be sending
+// the response to what was just forwarded.
+static void fk_pump_end(FkPump *pump) {
+    FkForwardedConnection *connection = pump->connection;
+
+    if (G_IS_SOCKET_CONNECTION(pump->to))
+        g_socket_shutdown(g_socket_connection_get_socket(G_SOCKET_CONNECTION(pump->to)), FALSE, TRUE, NULL);
+    else
+        g_output_stream_close_async(pump->output, G_PRIORITY_DEFAULT, NULL, NULL, NULL);
+
+    if (++connection->pumps_ended == 2)
+        fk_forwarded_connection_shutdown(connection);
+}
+
+static void fk_pump_on_written(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkPump *pump = (FkPump *) user_data;
+    FkForwardedConnection *connection = pump->connection;
+    gsize written = 0;
+
+    if (!g_output_stream_write_all_finish(G_OUTPUT_STREAM(source), result, &written, NULL)) {
+        fk_forwarded_connection_shutdown(connection);
+        fk_forwarded_connection_unref(connection);
+        return;
+    }
+
+    gint64 elapsed = g_get_monotonic_time() - pump->read_at;
+    FkForwarder *forwarder = connection->forwarder;
+    g_mutex_lock(&forwarder->lock);
+    if (pump->to_device)
+        forwarder->stats.bytes_to_device += (gint64) written;
+    else
+        forwarder->stats.bytes_from_device += (gint64) written;
+    forwarder->stats.chunks++;
+    forwarder->stats.chunk_us_total += elapsed;
+    forwarder->stats.chunk_us_max = MAX(forwarder->stats.chunk_us_max, elapsed);
+    g_mutex_unlock(&forwarder->lock);
+
+    fk_pump_read(pump);
+    fk_forwarded_connection_unref(connection);
+}
+
+static void fk_pump_on_read(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkPump *pump = (FkPump *) user_data;
+    FkForwardedConnection *connection = pump->connection;
+
+    gssize n = g_input_stream_read_finish(G_INPUT_STREAM(source), result, NULL);
+    if (n <= 0) {
+        if (n == 0)
+            fk_pump_end(pump);
+        else
+            fk_forwarded_connection_shutdown(connection);
+        fk_forwarded_connection_unref(connection);
+        return;
+    }
+
+    pump->read_at = g_get_monotonic_time();
+    g_output_stream_write_all_async(pump->output, pump->buffer, (gsize) n, G_PRIORITY_DEFAULT,
+                                    connection->cancellable, fk_pump_on_written, pump);
+}
+
+// Each in-flight operation holds a connection ref, handed from read to write.
+static void fk_pump_read(FkPump *pump) {
+    FkForwardedConnection *connection = fk_forwarded_connection_ref(pump->connection);
+    g_input_stream_read_async(pump->input, pump->buffer, sizeof(pump->buffer), G_PRIORITY_DEFAULT,
+                              connection->cancellable, fk_pump_on_read, pump);
+}
+
+static void fk_pump_start(FkPump *pump, FkForwardedConnection *connection, GIOStream *from, GIOStream *to,
+                          gboolean to_device) {
+    pump->connection = connection;
+    pump->input = g_io_stream_get_input_stream(from);
+    pump->to = to;
+    pump->output = g_io_stream_get_output_stream(to);
+    pump->to_device = to_device;
+    fk_pump_read(pump);
+}
+
+static void fk_forwarder_on_channel_opened(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkForwardedConnection *connection = (FkForwardedConnection *) user_data;
+    FkForwarder *forwarder = connection->forwarder;
+
+    GIOStream *remote = frida_device_open_channel_finish(FRIDA_DEVICE(source), result, NULL);
+    gint64 elapsed = g_get_monotonic_time() - connection->accepted_at;
+
+    g_mutex_lock(&forwarder->lock);
+    if (remote == NULL) {
+        forwarder->stats.failed++;
+    } else {
+        forwarder->stats.open_us_total += elapsed;
+        forwarder->stats.open_us_max = MAX(forwarder->stats.open_us_max, elapsed);
+    }
+    g_mutex_unlock(&forwarder->lock);
+
+    if (remote == NULL || g_cancellable_is_cancelled(connection->cancellable)) {
+        if (remote != NULL)
+            g_object_unref(remote);
+        fk_forwarded_connection_shutdown(connection);
+    } else {
+        connection->remote = remote;
+        fk_pump_start(&connection->upstream, connection, connection->local, remote, TRUE);
+        fk_pump_start(&connection->downstream, connection, remote, connection->local, FALSE);
+    }
+
+    fk_forwarded_connection_unref(connection);
+}
+
+static gboolean fk_forwarder_on_incoming(GSocketService *service, GSocketConnection *local, GObject *source_object,
+                                         gpointer user_data) {
+    FkForwarder *self = (FkForwarder *) user_data;
+
+    FkForwardedConnection *connection = g_new0(FkForwardedConnection, 1);
+    connection->ref_count = 1;
+    connection->forwarder = fk_forwarder_ref(self);
+    connection->local = (GIOStream *) g_object_ref(local);
+    connection->cancellable = g_cancellable_new();
+    connection->accepted_at = g_get_monotonic_time();
+
+    // The table holds a ref until the connection shuts down.
+    g_hash_table_add(self->connections, fk_forwarded_connection_ref(connection));
+
+    g_mutex_lock(&self->lock);
+    self->stats.accepted++;
+    self->stats.active++;
+    g_mutex_unlock(&self->lock);
+
+    g_socket_set_option(g_socket_connection_get_socket(local), IPPROTO_TCP, TCP_NODELAY, 1, NULL);
+
+    frida_device_open_channel(self->device, self->remote_address, connection->cancellable,
+                              fk_forwarder_on_channel_opened, connection);
+
+    return TRUE;
+}
+
+struct FkForwarderStart {
+    FkForwarder *forwarder;
+    const gchar *address;
+    guint16 port;
+    GError **error;
+};
+
+static void fk_forwarder_start(gpointer user_data) {
+    FkForwarderStart *start = (FkForwarderStart *) user_data;
+    FkForwarder *self = start->forwarder;
+
+    // The listener dispatches on the thread-default context at start time.
+    g_main_context_push_thread_default(frida_get_main_context());
+
+    GSocketAddress *address = g_inet_socket_address_new_from_string(start->address, start->port);
+    if (address == NULL) {
+        g_set_error(start->error, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT, "Invalid listen address: %s",
+                    start->address);
+    } else {
+        GSocketAddress *effective = NULL;
+        self->service = g_socket_service_new();
+        if (g_socket_listener_add_address(G_SOCKET_LISTENER(self->service), address, G_SOCKET_TYPE_STREAM,
+                                          G_SOCKET_PROTOCOL_TCP, NULL, &effective, start->error)) {
+            self->port = g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(effective));
+            g_object_unref(effective);
+            self->incoming_handler =
+                g_signal_connect(self->service, "incoming", G_CALLBACK(fk_forwarder_on_incoming), self);
+            g_socket_service_start(self->service);
+        } else {
+            g_clear_object(&self->service);
+        }
+        g_object_unref(address);
+    }
+
+    g_main_context_pop_thread_default(frida_get_main_context());
+}
+
+static void fk_forwarder_stop(gpointer user_data) {
+    FkForwarder *self = (FkForwarder *) user_data;
+
+    if (self->service != NULL) {
+        g_signal_handler_disconnect(self->service, self->incoming_handler);
+        g_socket_service_stop(self->service);
+        g_socket_listener_close(G_SOCKET_LISTENER(self->service));
+        g_clear_object(&self->service);
+    }
+
+    GHashTableIter iter;
+    gpointer connection;
+    g_hash_table_iter_init(&iter, self->connections);
+    while (g_hash_table_iter_next(&iter, &connection, NULL))
+        g_cancellable_cancel(((FkForwardedConnection *) connection)->cancellable);
+    g_hash_table_remove_all(self->connections);
+}
+
+FkForwarder *fk_forwarder_new(FridaDevice *device, const gchar *remote_address, const gchar *address, guint16 port,
+                              GError **error) {
+    FkForwarder *self = g_new0(FkForwarder, 1);
+    self->ref_count = 1;
+    self->device = (FridaDevice *) g_object_ref(device);
+    self->remote_address = g_strdup(remote_address);
+    self->connections =
+        g_hash_table_new_full(NULL, NULL, (GDestroyNotify) fk_forwarded_connection_unref, NULL);
+    g_mutex_init(&self->lock);
+
+    GError *local_error = NULL;
+    FkForwarderStart start = { self, address != NULL ? address : "127.0.0.1", port, &local_error };
+    fk_invoke_sync(fk_forwarder_start, &start);
+
+    if (local_error != NULL) {
+        g_propagate_error(error, local_error);
+        fk_forwarder_unref(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+void fk_forwarder_free(FkForwarder *self) {
+    if (self == NULL)
+        return;
+    fk_invoke_sync(fk_forwarder_stop, self);
+    fk_forwarder_unref(self);
+}
+
+guint16 fk_forwarder_get_port(FkForwarder *self) {
+    return self->port;
+}
+
+GBytes *fk_forwarder_get_stats(FkForwarder *self) {
+    g_mutex_lock(&self->lock);
+    FkForwarderStats stats = self->stats;
+    g_mutex_unlock(&self->lock);
+
+    FkWriter writer;
+    writer.put_i64(stats.accepted);
+    writer.put_i64(stats.active);
+    writer.put_i64(stats.failed);
+    writer.put_i64(stats.bytes_to_device);
+    writer.put_i64(stats.bytes_from_device);
+    writer.put_i64(stats.open_us_total);
+    writer.put_i64(stats.open_us_max);
+    writer.put_i64(stats.chunks);
+    writer.put_i64(stats.chunk_us_total);
+    writer.put_i64(stats.chunk_us_max);
+    return writer.steal();
+}
@@ -0,0 +1,28 @@
+#ifndef __FK_FORWARDER_H__
+#define __FK_FORWARDER_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Local TCP port forwarder: listens on address:port and splices every accepted
+// connection to a fresh device channel at remote_address (e.g. "tcp:8080"),
+// entirely on the frida main context. Bytes are pumped through a native
+// buffer per direction and never reach the JVM. A port of 0 picks a free one.
+//
+// Stats snapshot, all i64: accepted, active, failed, bytes to device, bytes
+// from device, channel open us total, channel open us max, chunks forwarded,
+// chunk us total, chunk us max (chunk latency is read completion to write
+// completion).
+typedef struct _FkForwarder FkForwarder;
+
+FkForwarder *fk_forwarder_new(FridaDevice *device, const gchar *remote_address, const gchar *address, guint16 port,
+                              GError **error);
+void fk_forwarder_free(FkForwarder *self);
+
+guint16 fk_forwarder_get_port(FkForwarder *self);
+GBytes *fk_forwarder_get_stats(FkForwarder *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,105 @@
+#include "fk_hot_reload.h"
+#include "fk_main_context.h"
+#include "fk_marshal.h"
+
+struct _FkHotReload {
+    FridaCompiler *compiler;
+    FkAgent *agent;
+    FkEventQueue *events;
+    GCancellable *cancellable;
+    gulong starting_handler;
+    gulong finished_handler;
+    gulong output_handler;
+    gulong diagnostics_handler;
+};
+
+static void fk_hot_reload_publish_kind(FkHotReload *self, FkHotReloadEvent kind) {
+    guint8 value = kind;
+    fk_event_queue_push(self->events, &value, 1);
+}
+
+static void fk_hot_reload_on_starting(FridaCompiler *compiler, gpointer user_data) {
+    fk_hot_reload_publish_kind((FkHotReload *) user_data, FK_HOT_RELOAD_STARTING);
+}
+
+static void fk_hot_reload_on_finished(FridaCompiler *compiler, gpointer user_data) {
+    fk_hot_reload_publish_kind((FkHotReload *) user_data, FK_HOT_RELOAD_FINISHED);
+}
+
+static void fk_hot_reload_on_output(FridaCompiler *compiler, const gchar *bundle, gpointer user_data) {
+    FkHotReload *self = (FkHotReload *) user_data;
+
+    fk_agent_replace_source(self->agent, bundle);
+
+    FkWriter writer;
+    writer.put_u8(FK_HOT_RELOAD_OUTPUT);
+    writer.put_u32((guint32) strlen(bundle));
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_hot_reload_on_diagnostics(FridaCompiler *compiler, GVariant *diagnostics, gpointer user_data) {
+    FkHotReload *self = (FkHotReload *) user_data;
+    FkWriter writer;
+    writer.put_u8(FK_HOT_RELOAD_DIAGNOSTICS);
+    fk_write_variant(writer, diagnostics);
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_hot_reload_connect(gpointer user_data) {
+    FkHotReload *self = (FkHotReload *) user_data;
+    if (self->output_handler != 0)
+        return;
+    self->starting_handler =
+        g_signal_connect(self->compiler, "starting", G_CALLBACK(fk_hot_reload_on_starting), self);
+    self->finished_handler =
+        g_signal_connect(self->compiler, "finished", G_CALLBACK(fk_hot_reload_on_finished), self);
+    self->output_handler = g_signal_connect(self->compiler, "output", G_CALLBACK(fk_hot_reload_on_output), self);
+    self->diagnostics_handler =
+        g_signal_connect(self->compiler, "diagnostics", G_CALLBACK(fk_hot_reload_on_diagnostics), self);
+}
+
+static void fk_hot_reload_disconnect(gpointer user_data) {
+    FkHotReload *self = (FkHotReload *) user_data;
+    if (self->output_handler == 0)
+        return;
+    g_signal_handler_disconnect(self->compiler, self->starting_handler);
+    g_signal_handler_disconnect(self->compiler, self->finished_handler);
+    g_signal_handler_disconnect(self->compiler, self->output_handler);
+    g_signal_handler_disconnect(self->compiler, self->diagnostics_handler);
+}
+
+FkHotReload *fk_hot_reload_new(FkDeviceRegistry *registry, FkAgent *agent, guint capacity) {
+    FkHotReload *self = g_new0(FkHotReload, 1);
+    self->compiler = frida_compiler_new(fk_device_registry_get_manager(registry));
+    self->agent = fk_agent_ref(agent);
+    self->events = fk_event_queue_new(capacity);
+    self->cancellable = g_cancellable_new();
+    return self;
+}
+
+void fk_hot_reload_free(FkHotReload *self) {
+    if (self == NULL)
+        return;
+    g_cancellable_cancel(self->cancellable);
+    fk_invoke_sync(fk_hot_reload_disconnect, self);
+    fk_event_queue_close(self->events);
+    fk_event_queue_free(self->events);
+    g_object_unref(self->cancellable);
+    g_object_unref(self->compiler);
+    fk_agent_unref(self->agent);
+    g_free(self);
+}
+
+void fk_hot_reload_watch_sync(FkHotReload *self, const gchar *entrypoint, const gchar *project_root, GError **error) {
+    fk_invoke_sync(fk_hot_reload_connect, self);
+
+    FridaWatchOptions *options = frida_watch_options_new();
+    if (project_root != NULL)
+        frida_compiler_options_set_project_root(FRIDA_COMPILER_OPTIONS(options), project_root);
+    frida_compiler_watch_sync(self->compiler, entrypoint, options, self->cancellable, error);
+    g_object_unref(options);
+}
+
+FkEventQueue *fk_hot_reload_get_events(FkHotReload *self) {
+    return self->events;
+}
@@ -0,0 +1,35 @@
+#ifndef __FK_HOT_RELOAD_H__
+#define __FK_HOT_RELOAD_H__
+
+#include "frida_core.h"
+#include "fk_agent.h"
+#include "fk_device_registry.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Runs frida_compiler_watch on an entrypoint and feeds every bundle it
+// outputs straight into fk_agent_replace_source on the main context, so all
+// sessions the agent is loaded into pick up each edit without detaching.
+// Build progress is published as:
+//   u8 FkHotReloadEvent, then
+//   DIAGNOSTICS: variant
+//   OUTPUT:      u32 bundle size
+typedef struct _FkHotReload FkHotReload;
+
+typedef enum {
+    FK_HOT_RELOAD_STARTING,
+    FK_HOT_RELOAD_FINISHED,
+    FK_HOT_RELOAD_DIAGNOSTICS,
+    FK_HOT_RELOAD_OUTPUT
+} FkHotReloadEvent;
+
+FkHotReload *fk_hot_reload_new(FkDeviceRegistry *registry, FkAgent *agent, guint capacity);
+void fk_hot_reload_free(FkHotReload *self);
+
+void fk_hot_reload_watch_sync(FkHotReload *self, const gchar *entrypoint, const gchar *project_root, GError **error);
+FkEventQueue *fk_hot_reload_get_events(FkHotReload *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,275 @@
+#include "fk_icon.h"
+
+struct _FkIcon {
+    volatile gint ref_count;
+    GVariant *image;
+    gchar *format;
+    gint width;
+    gint height;
+};
+
+struct FkIconEntry {
+    gchar *key;
+    FkIcon *icon;
+};
+
+struct _FkIconCache {
+    GMutex lock;
+    guint capacity;
+    GHashTable *entries;
+    GQueue order;
+};
+
+static gint fk_variant_to_int(GVariant *value) {
+    if (value == NULL)
+        return 0;
+    switch (g_variant_classify(value)) {
+        case G_VARIANT_CLASS_INT64:
+            return (gint) g_variant_get_int64(value);
+        case G_VARIANT_CLASS_UINT64:
+            return (gint) g_variant_get_uint64(value);
+        case G_VARIANT_CLASS_INT32:
+            return g_variant_get_int32(value);
+        case G_VARIANT_CLASS_UINT32:
+            return (gint) g_variant_get_uint32(value);
+        default:
+            return 0;
+    }
+}
+
+// icon is an a{sv} with format, width, height and image (ay).
+static FkIcon *fk_icon_new(GVariant *icon) {
+    GVariant *image = g_variant_lookup_value(icon, "image", G_VARIANT_TYPE_BYTESTRING);
+    if (image == NULL)
+        return NULL;
+
+    FkIcon *self = g_new0(FkIcon, 1);
+    self->ref_count = 1;
+    self->image = image;
+
+    GVariant *format = g_variant_lookup_value(icon, "format", G_VARIANT_TYPE_STRING);
+    self->format = g_strdup(format != NULL ? g_variant_get_string(format, NULL) : "");
+    GVariant *width = g_variant_lookup_value(icon, "width", NULL);
+    GVariant *height = g_variant_lookup_value(icon, "height", NULL);
+    self->width = fk_variant_to_int(width);
+    self->height = fk_variant_to_int(height);
+
+    if (format != NULL)
+        g_variant_unref(format);
+    if (width != NULL)
+        g_variant_unref(width);
+    if (height != NULL)
+        g_variant_unref(height);
+
+    return self;
+}
+
+FkIcon *fk_icon_ref(FkIcon *self) {
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+void fk_icon_unref(FkIcon *self) {
+    if (self == NULL || !g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+    g_variant_unref(self->image);
+    g_free(self->format);
+    g_free(self);
+}
+
+const gchar *fk_icon_get_format(FkIcon *self) {
+    return self->format;
+}
+
+gint fk_icon_get_width(FkIcon *self) {
+    return self->width;
+}
+
+gint fk_icon_get_height(FkIcon *self) {
+    return self->height;
+}
+
+FkDirectBuffer fk_icon_get_pixels(FkIcon *self) {
+    FkDirectBuffer buffer;
+    buffer.data = g_variant_get_fixed_array(self->image, &buffer.size, 1);
+    return buffer;
+}
+
+static void fk_icon_entry_free(gpointer data) {
+    FkIconEntry *entry = (FkIconEntry *) data;
+    fk_icon_unref(entry->icon);
+    g_free(entry->key);
+    g_free(entry);
+}
+
+static gchar *fk_icon_cache_key(FridaDevice *device, const gchar *identifier, gint width) {
+    return g_strdup_printf("%s\n%s\n%d", frida_device_get_id(device), identifier, width);
+}
+
+FkIconCache *fk_icon_cache_new(guint capacity) {
+    FkIconCache *self = g_new0(FkIconCache, 1);
+    g_mutex_init(&self->lock);
+    self->capacity = capacity;
+    self->entries = g_hash_table_new(g_str_hash, g_str_equal);
+    g_queue_init(&self->order);
+    return self;
+}
+
+void fk_icon_cache_free(FkIconCache *self) {
+    if (self == NULL)
+        return;
+    fk_icon_cache_clear(self);
+    g_hash_table_unref(self->entries);
+    g_mutex_clear(&self->lock);
+    g_free(self);
+}
+
+void fk_icon_cache_clear(FkIconCache *self) {
+    g_mutex_lock(&self->lock);
+    g_hash_table_remove_all(self->entries);
+    g_queue_clear_full(&self->order, fk_icon_entry_free);
+    g_mutex_unlock(&self->lock);
+}
+
+// Most recently used first; the hash table maps keys to their queue links.
+static FkIcon *fk_icon_cache_lookup(FkIconCache *self, const gchar *key) {
+    g_mutex_lock(&self->lock);
+    GList *link = (GList *) g_hash_table_lookup(self->entries, key);
+    FkIcon *icon = NULL;
+    if (link != NULL) {
+        g_queue_unlink(&self->order, link);
+        g_queue_push_head_link(&self->order, link);
+        icon = fk_icon_ref(((FkIconEntry *) link->data)->icon);
+    }
+    g_mutex_unlock(&self->lock);
+    return icon;
+}
+
+// Takes ownership of key.
+static void fk_icon_cache_insert(FkIconCache *self, gchar *key, FkIcon *icon) {
+    if (self->capacity == 0) {
+        g_free(key);
+        return;
+    }
+
+    g_mutex_lock(&self->lock);
+    GList *existing = (GList *) g_hash_table_lookup(self->entries, key);
+    if (existing != NULL) {
+        FkIconEntry *replaced = (FkIconEntry *) existing->data;
+        g_hash_table_remove(self->entries, key);
+        g_queue_delete_link(&self->order, existing);
+        fk_icon_entry_free(replaced);
+    }
+
+    FkIconEntry *entry = g_new0(FkIconEntry, 1);
+    entry->key = key;
+    entry->icon = fk_icon_ref(icon);
+    g_queue_push_head(&self->order, entry);
+    g_hash_table_insert(self->entries, entry->key, self->order.head);
+
+    while (self->order.length > self->capacity) {
+        FkIconEntry *evicted = (FkIconEntry *) g_queue_pop_tail(&self->order);
+        g_hash_table_remove(self->entries, evicted->key);
+        fk_icon_entry_free(evicted);
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+// Caches every icon of one application, plus the largest under width 0, and
+// returns a new ref on the one matching width (NULL if absent).
+static FkIcon *fk_icon_cache_add_application(FkIconCache *self, FridaDevice *device, FridaApplication *application,
+                                             gint width) {
+    GVariant *icons = (GVariant *) g_hash_table_lookup(frida_application_get_parameters(application), "icons");
+    if (icons == NULL || !g_variant_is_container(icons))
+        return NULL;
+
+    const gchar *identifier = frida_application_get_identifier(application);
+    FkIcon *largest = NULL;
+    FkIcon *match = NULL;
+
+    gsize count = g_variant_n_children(icons);
+    for (gsize i = 0; i != count; i++) {
+        GVariant *child = g_variant_get_child_value(icons, i);
+        GVariant *dict = g_variant_is_of_type(child, G_VARIANT_TYPE_VARIANT) ? g_variant_get_variant(child)
+                                                                             : g_variant_ref(child);
+        FkIcon *icon = g_variant_is_of_type(dict, G_VARIANT_TYPE_VARDICT) ? fk_icon_new(dict) : NULL;
+        g_variant_unref(dict);
+        g_variant_unref(child);
+        if (icon == NULL)
+            continue;
+
+        fk_icon_cache_insert(self, fk_icon_cache_key(device, identifier, icon->width), icon);
+        if (match == NULL && width != 0 && icon->width == width)
+            match = fk_icon_ref(icon);
+        if (largest == NULL || icon->width > largest->width) {
+            fk_icon_unref(largest);
+            largest = icon;
+        } else {
+            fk_icon_unref(icon);
+        }
+    }
+
+    if (largest != NULL) {
+        fk_icon_cache_insert(self, fk_icon_cache_key(device, identifier, 0), largest);
+        if (width == 0)
+            match = fk_icon_ref(largest);
+        fk_icon_unref(largest);
+    }
+
+    return match;
+}
+
+static FridaApplicationList *fk_icon_cache_query(FridaDevice *device, const gchar *identifier, GError **error) {
+    FridaApplicationQueryOptions *options = frida_application_query_options_new();
+    frida_application_query_options_set_scope(options, FRIDA_SCOPE_FULL);
+    if (identifier != NULL)
+        frida_application_query_options_select_identifier(options, identifier);
+    FridaApplicationList *list = frida_device_enumerate_applications_sync(device, options, NULL, error);
+    g_object_unref(options);
+    return list;
+}
+
+FkIcon *fk_icon_cache_get_application_icon(FkIconCache *self, FridaDevice *device, const gchar *identifier,
+                                           gint width, GError **error) {
+    gchar *key = fk_icon_cache_key(device, identifier, width);
+    FkIcon *icon = fk_icon_cache_lookup(self, key);
+    g_free(key);
+    if (icon != NULL)
+        return icon;
+
+    FridaApplicationList *list = fk_icon_cache_query(device, identifier, error);
+    if (list == NULL)
+        return NULL;
+
+    gint size = frida_application_list_size(list);
+    for (gint i = 0; i != size && icon == NULL; i++) {
+        FridaApplication *application = frida_application_list_get(list, i);
+        if (strcmp(frida_application_get_identifier(application), identifier) == 0)
+            icon = fk_icon_cache_add_application(self, device, application, width);
+        g_object_unref(application);
+    }
+    g_object_unref(list);
+
+    return icon;
+}
+
+FkIcon *fk_icon_new_for_device(FridaDevice *device) {
+    GVariant *variant = frida_device_get_icon(device);
+    if (variant == NULL || !g_variant_is_of_type(variant, G_VARIANT_TYPE_VARDICT))
+        return NULL;
+    return fk_icon_new(variant);
+}
+
+void fk_icon_cache_prefetch_applications(FkIconCache *self, FridaDevice *device, GError **error) {
+    FridaApplicationList *list = fk_icon_cache_query(device, NULL, error);
+    if (list == NULL)
+        return;
+
+    gint size = frida_application_list_size(list);
+    for (gint i = 0; i != size; i++) {
+        FridaApplication *application = frida_application_list_get(list, i);
+        fk_icon_unref(fk_icon_cache_add_application(self, device, application, -1));
+        g_object_unref(application);
+    }
+    g_object_unref(list);
+}
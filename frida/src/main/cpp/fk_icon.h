@@ -0,0 +1,45 @@
+#ifndef __FK_ICON_H__
+#define __FK_ICON_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// A contiguous native byte range handed to Kotlin as a direct ByteBuffer. It
+// stays valid only as long as whatever owns it.
+typedef struct {
+    gconstpointer data;
+    gsize size;
+} FkDirectBuffer;
+
+// An icon holds a ref on the GVariant it came from; its pixels are the
+// variant's own fixed-size data, never copied.
+typedef struct _FkIcon FkIcon;
+
+FkIcon *fk_icon_ref(FkIcon *self);
+void fk_icon_unref(FkIcon *self);
+const gchar *fk_icon_get_format(FkIcon *self);
+gint fk_icon_get_width(FkIcon *self);
+gint fk_icon_get_height(FkIcon *self);
+FkDirectBuffer fk_icon_get_pixels(FkIcon *self);
+
+// The device's own icon; NULL if it has none.
+FkIcon *fk_icon_new_for_device(FridaDevice *device);
+
+// LRU of icons keyed by device id + identifier + width, holding at most
+// capacity icons (0 disables caching). A width of 0 asks for the largest.
+// Lookups return a new ref, or NULL when there is no such icon.
+typedef struct _FkIconCache FkIconCache;
+
+FkIconCache *fk_icon_cache_new(guint capacity);
+void fk_icon_cache_free(FkIconCache *self);
+
+FkIcon *fk_icon_cache_get_application_icon(FkIconCache *self, FridaDevice *device, const gchar *identifier,
+                                           gint width, GError **error);
+// Fills the cache with every application icon in one query.
+void fk_icon_cache_prefetch_applications(FkIconCache *self, FridaDevice *device, GError **error);
+void fk_icon_cache_clear(FkIconCache *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,322 @@
+#include "fk_injection.h"
+#include "fk_main_context.h"
+#include "fk_writer.h"
+
+struct FkBlob {
+    guint id;
+    gchar *checksum;
+    GBytes *bytes;
+    guint holds;
+    guint injections;
+};
+
+struct FkInjected {
+    guint pid;
+    FkBlob *blob;
+};
+
+struct _FkInjection {
+    FridaDevice *device;
+    FridaInjector *injector;
+    FkEventQueue *events;
+    GMutex lock;
+    GHashTable *by_checksum;
+    GHashTable *by_id;
+    GHashTable *injected;
+    GHashTable *early_uninjected;
+    guint in_flight;
+    guint next_blob_id;
+    gulong uninjected_handler;
+};
+
+static void fk_blob_free(gpointer data) {
+    FkBlob *blob = (FkBlob *) data;
+    g_bytes_unref(blob->bytes);
+    g_free(blob->checksum);
+    g_free(blob);
+}
+
+// Caller holds the lock.
+static void fk_injection_maybe_drop(FkInjection *self, FkBlob *blob) {
+    if (blob->holds != 0 || blob->injections != 0)
+        return;
+    g_hash_table_remove(self->by_checksum, blob->checksum);
+    g_hash_table_remove(self->by_id, GUINT_TO_POINTER(blob->id));
+}
+
+// Caller holds the lock. Returns whether the injection was tracked, and if
+// so the pid it was made into.
+static gboolean fk_injection_untrack(FkInjection *self, guint id, guint *pid) {
+    FkInjected *injected = (FkInjected *) g_hash_table_lookup(self->injected, GUINT_TO_POINTER(id));
+    if (injected == NULL)
+        return FALSE;
+    if (pid != NULL)
+        *pid = injected->pid;
+    if (injected->blob != NULL) {
+        injected->blob->injections--;
+        fk_injection_maybe_drop(self, injected->blob);
+    }
+    g_hash_table_remove(self->injected, GUINT_TO_POINTER(id));
+    return TRUE;
+}
+
+static void fk_injection_publish_uninjected(FkInjection *self, guint id, guint pid) {
+    FkWriter writer;
+    writer.put_u8(FK_INJECTION_UNINJECTED);
+    writer.put_u32(id);
+    writer.put_u32(pid);
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+// A payload that does not stay resident can be uninjected before the
+// injecting thread has tracked it; such ids are held back while injections
+// are in flight and reconciled in fk_injection_finish.
+static void fk_injection_on_uninjected(GObject *source, guint id, gpointer user_data) {
+    FkInjection *self = (FkInjection *) user_data;
+
+    g_mutex_lock(&self->lock);
+    guint pid = 0;
+    gboolean tracked = fk_injection_untrack(self, id, &pid);
+    gboolean early = !tracked && self->in_flight != 0;
+    if (early)
+        g_hash_table_add(self->early_uninjected, GUINT_TO_POINTER(id));
+    g_mutex_unlock(&self->lock);
+
+    if (!early)
+        fk_injection_publish_uninjected(self, id, pid);
+}
+
+static GObject *fk_injection_get_source(FkInjection *self) {
+    return self->device != NULL ? G_OBJECT(self->device) : G_OBJECT(self->injector);
+}
+
+static void fk_injection_connect(gpointer user_data) {
+    FkInjection *self = (FkInjection *) user_data;
+    self->uninjected_handler = g_signal_connect(fk_injection_get_source(self), "uninjected",
+                                                G_CALLBACK(fk_injection_on_uninjected), self);
+}
+
+static void fk_injection_disconnect(gpointer user_data) {
+    FkInjection *self = (FkInjection *) user_data;
+    g_signal_handler_disconnect(fk_injection_get_source(self), self->uninjected_handler);
+}
+
+static FkInjection *fk_injection_new(FridaDevice *device, FridaInjector *injector, guint capacity) {
+    FkInjection *self = g_new0(FkInjection, 1);
+    self->device = device;
+    self->injector = injector;
+    self->events = fk_event_queue_new(capacity);
+    g_mutex_init(&self->lock);
+    self->by_checksum = g_hash_table_new(g_str_hash, g_str_equal);
+    self->by_id = g_hash_table_new_full(NULL, NULL, NULL, fk_blob_free);
+    self->injected = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    self->early_uninjected = g_hash_table_new(NULL, NULL);
+
+    fk_invoke_sync(fk_injection_connect, self);
+
+    return self;
+}
+
+FkInjection *fk_injection_new_for_device(FridaDevice *device, guint capacity) {
+    return fk_injection_new((FridaDevice *) g_object_ref(device), NULL, capacity);
+}
+
+FkInjection *fk_injection_new_local(gboolean inprocess, guint capacity) {
+    return fk_injection_new(NULL, inprocess ? frida_injector_new_inprocess() : frida_injector_new(), capacity);
+}
+
+void fk_injection_free(FkInjection *self) {
+    if (self == NULL)
+        return;
+
+    fk_invoke_sync(fk_injection_disconnect, self);
+    if (self->injector != NULL) {
+        frida_injector_close_sync(self->injector, NULL, NULL);
+        g_object_unref(self->injector);
+    }
+    if (self->device != NULL)
+        g_object_unref(self->device);
+
+    fk_event_queue_close(self->events);
+    fk_event_queue_free(self->events);
+    g_hash_table_unref(self->injected);
+    g_hash_table_unref(self->early_uninjected);
+    g_hash_table_unref(self->by_checksum);
+    g_hash_table_unref(self->by_id);
+    g_mutex_clear(&self->lock);
+    g_free(self);
+}
+
+// Takes ownership of bytes.
+static guint fk_injection_intern(FkInjection *self, GBytes *bytes) {
+    gchar *checksum = g_compute_checksum_for_bytes(G_CHECKSUM_SHA256, bytes);
+
+    g_mutex_lock(&self->lock);
+    FkBlob *blob = (FkBlob *) g_hash_table_lookup(self->by_checksum, checksum);
+    if (blob == NULL) {
+        blob = g_new0(FkBlob, 1);
+        blob->id = ++self->next_blob_id;
+        blob->checksum = checksum;
+        blob->bytes = bytes;
+        g_hash_table_insert(self->by_checksum, blob->checksum, blob);
+        g_hash_table_insert(self->by_id, GUINT_TO_POINTER(blob->id), blob);
+    } else {
+        g_free(checksum);
+        g_bytes_unref(bytes);
+    }
+    blob->holds++;
+    guint id = blob->id;
+    g_mutex_unlock(&self->lock);
+
+    return id;
+}
+
+guint fk_injection_add_blob(FkInjection *self, gconstpointer buffer, gsize size) {
+    return fk_injection_intern(self, g_bytes_new(buffer, size));
+}
+
+guint fk_injection_add_blob_file(FkInjection *self, const gchar *path, GError **error) {
+    gchar *contents;
+    gsize length;
+    if (!g_file_get_contents(path, &contents, &length, error))
+        return 0;
+    return fk_injection_intern(self, g_bytes_new_take(contents, length));
+}
+
+void fk_injection_release_blob(FkInjection *self, guint blob) {
+    g_mutex_lock(&self->lock);
+    FkBlob *entry = (FkBlob *) g_hash_table_lookup(self->by_id, GUINT_TO_POINTER(blob));
+    if (entry != NULL && entry->holds != 0) {
+        entry->holds--;
+        fk_injection_maybe_drop(self, entry);
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+guint fk_injection_get_blob_count(FkInjection *self) {
+    g_mutex_lock(&self->lock);
+    guint count = g_hash_table_size(self->by_id);
+    g_mutex_unlock(&self->lock);
+    return count;
+}
+
+// Ends an injection started with in_flight bumped. A successful one is
+// tracked unless it has already been uninjected, in which case its blob is
+// released and the held-back event published now. Once nothing is in flight,
+// ids still held back belonged to other injectors on the device.
+static void fk_injection_finish(FkInjection *self, guint id, guint pid, FkBlob *blob, gboolean succeeded) {
+    GList *foreign = NULL;
+    gboolean uninjected = FALSE;
+
+    g_mutex_lock(&self->lock);
+    self->in_flight--;
+    if (succeeded && g_hash_table_remove(self->early_uninjected, GUINT_TO_POINTER(id))) {
+        uninjected = TRUE;
+    } else if (succeeded) {
+        FkInjected *injected = g_new0(FkInjected, 1);
+        injected->pid = pid;
+        injected->blob = blob;
+        g_hash_table_replace(self->injected, GUINT_TO_POINTER(id), injected);
+        blob = NULL;
+    }
+    if (blob != NULL) {
+        blob->injections--;
+        fk_injection_maybe_drop(self, blob);
+    }
+    if (self->in_flight == 0) {
+        foreign = g_hash_table_get_keys(self->early_uninjected);
+        g_hash_table_remove_all(self->early_uninjected);
+    }
+    g_mutex_unlock(&self->lock);
+
+    if (uninjected)
+        fk_injection_publish_uninjected(self, id, pid);
+    for (GList *cur = foreign; cur != NULL; cur = cur->next)
+        fk_injection_publish_uninjected(self, GPOINTER_TO_UINT(cur->data), 0);
+    g_list_free(foreign);
+}
+
+guint fk_injection_inject_blob_sync(FkInjection *self, guint pid, guint blob, const gchar *entrypoint,
+                                    const gchar *data, GError **error) {
+    // Count the injection up front so a concurrent release cannot drop the
+    // blob while it is being injected.
+    g_mutex_lock(&self->lock);
+    FkBlob *entry = (FkBlob *) g_hash_table_lookup(self->by_id, GUINT_TO_POINTER(blob));
+    GBytes *bytes = NULL;
+    if (entry != NULL) {
+        entry->injections++;
+        bytes = g_bytes_ref(entry->bytes);
+        self->in_flight++;
+    }
+    g_mutex_unlock(&self->lock);
+
+    if (bytes == NULL) {
+        g_set_error(error, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT, "Unknown blob %u", blob);
+        return 0;
+    }
+
+    GError *local_error = NULL;
+    guint id = self->device != NULL
+        ? frida_device_inject_library_blob_sync(self->device, pid, bytes, entrypoint, data, NULL, &local_error)
+        : frida_injector_inject_library_blob_sync(self->injector, pid, bytes, entrypoint, data, NULL, &local_error);
+    g_bytes_unref(bytes);
+
+    fk_injection_finish(self, id, pid, entry, local_error == NULL);
+
+    if (local_error != NULL)
+        g_propagate_error(error, local_error);
+    return id;
+}
+
+guint fk_injection_inject_file_sync(FkInjection *self, guint pid, const gchar *path, const gchar *entrypoint,
+                                    const gchar *data, GError **error) {
+    g_mutex_lock(&self->lock);
+    self->in_flight++;
+    g_mutex_unlock(&self->lock);
+
+    GError *local_error = NULL;
+    guint id = self->device != NULL
+        ? frida_device_inject_library_file_sync(self->device, pid, path, entrypoint, data, NULL, &local_error)
+        : frida_injector_inject_library_file_sync(self->injector, pid, path, entrypoint, data, NULL, &local_error);
+
+    fk_injection_finish(self, id, pid, NULL, local_error == NULL);
+
+    if (local_error != NULL) {
+        g_propagate_error(error, local_error);
+        return 0;
+    }
+    return id;
+}
+
+static gboolean fk_injection_require_injector(FkInjection *self, GError **error) {
+    if (self->injector != NULL)
+        return TRUE;
+    g_set_error_literal(error, FRIDA_ERROR, FRIDA_ERROR_NOT_SUPPORTED, "Only supported by local injectors");
+    return FALSE;
+}
+
+// A demonitored injection never reports uninjected, so stop tracking it here.
+void fk_injection_demonitor_sync(FkInjection *self, guint id, GError **error) {
+    if (!fk_injection_require_injector(self, error))
+        return;
+
+    GError *local_error = NULL;
+    frida_injector_demonitor_sync(self->injector, id, NULL, &local_error);
+    if (local_error != NULL) {
+        g_propagate_error(error, local_error);
+        return;
+    }
+
+    g_mutex_lock(&self->lock);
+    fk_injection_untrack(self, id, NULL);
+    g_mutex_unlock(&self->lock);
+}
+
+void fk_injection_recreate_thread_sync(FkInjection *self, guint pid, guint id, GError **error) {
+    if (fk_injection_require_injector(self, error))
+        frida_injector_recreate_thread_sync(self->injector, pid, id, NULL, error);
+}
+
+FkEventQueue *fk_injection_get_events(FkInjection *self) {
+    return self->events;
+}
@@ -0,0 +1,44 @@
+#ifndef __FK_INJECTION_H__
+#define __FK_INJECTION_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Library injection through a device or a local FridaInjector. Payloads are
+// registered once as native GBytes keyed by their SHA-256, so injecting the
+// same library into many processes reuses one buffer; registering identical
+// content again returns the same blob id. A blob lives while it is either
+// held (add/release) or backing an injection that has not yet unloaded.
+// Events, published on uninjected:
+//   u8 FkInjectionEvent, u32 injection id, u32 pid
+typedef struct _FkInjection FkInjection;
+
+typedef enum {
+    FK_INJECTION_UNINJECTED
+} FkInjectionEvent;
+
+FkInjection *fk_injection_new_for_device(FridaDevice *device, guint capacity);
+FkInjection *fk_injection_new_local(gboolean inprocess, guint capacity);
+void fk_injection_free(FkInjection *self);
+
+guint fk_injection_add_blob(FkInjection *self, gconstpointer buffer, gsize size);
+guint fk_injection_add_blob_file(FkInjection *self, const gchar *path, GError **error);
+void fk_injection_release_blob(FkInjection *self, guint blob);
+guint fk_injection_get_blob_count(FkInjection *self);
+
+guint fk_injection_inject_blob_sync(FkInjection *self, guint pid, guint blob, const gchar *entrypoint,
+                                    const gchar *data, GError **error);
+guint fk_injection_inject_file_sync(FkInjection *self, guint pid, const gchar *path, const gchar *entrypoint,
+                                    const gchar *data, GError **error);
+
+// Only supported by local injectors.
+void fk_injection_demonitor_sync(FkInjection *self, guint id, GError **error);
+void fk_injection_recreate_thread_sync(FkInjection *self, guint pid, guint id, GError **error);
+
+FkEventQueue *fk_injection_get_events(FkInjection *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,85 @@
+#include "fk_main_context.h"
+
+struct FkInvocation {
+    FkMainContextFunc func;
+    gpointer user_data;
+    GDestroyNotify notify;
+    GMutex lock;
+    GCond cond;
+    gboolean done;
+};
+
+static gboolean fk_invoke_sync_dispatch(gpointer data) {
+    FkInvocation *invocation = (FkInvocation *) data;
+
+    invocation->func(invocation->user_data);
+
+    g_mutex_lock(&invocation->lock);
+    invocation->done = TRUE;
+    g_cond_signal(&invocation->cond);
+    g_mutex_unlock(&invocation->lock);
+
+    return G_SOURCE_REMOVE;
+}
+
+void fk_invoke_sync(FkMainContextFunc func, gpointer user_data) {
+    GMainContext *context = frida_get_main_context();
+
+    if (g_main_context_is_owner(context)) {
+        func(user_data);
+        return;
+    }
+
+    FkInvocation invocation = { func, user_data, NULL };
+    g_mutex_init(&invocation.lock);
+    g_cond_init(&invocation.cond);
+    invocation.done = FALSE;
+
+    GSource *source = g_idle_source_new();
+    g_source_set_priority(source, G_PRIORITY_HIGH);
+    g_source_set_callback(source, fk_invoke_sync_dispatch, &invocation, NULL);
+    g_source_attach(source, context);
+    g_source_unref(source);
+
+    g_mutex_lock(&invocation.lock);
+    while (!invocation.done)
+        g_cond_wait(&invocation.cond, &invocation.lock);
+    g_mutex_unlock(&invocation.lock);
+
+    g_cond_clear(&invocation.cond);
+    g_mutex_clear(&invocation.lock);
+}
+
+static gboolean fk_invoke_async_dispatch(gpointer data) {
+    FkInvocation *invocation = (FkInvocation *) data;
+    invocation->func(invocation->user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static void fk_invoke_async_free(gpointer data) {
+    FkInvocation *invocation = (FkInvocation *) data;
+    if (invocation->notify != NULL)
+        invocation->notify(invocation->user_data);
+    g_free(invocation);
+}
+
+void fk_invoke_async(FkMainContextFunc func, gpointer user_data, GDestroyNotify notify) {
+    FkInvocation *invocation = g_new0(FkInvocation, 1);
+    invocation->func = func;
+    invocation->user_data = user_data;
+    invocation->notify = notify;
+
+    GSource *source = g_idle_source_new();
+    g_source_set_callback(source, fk_invoke_async_dispatch, invocation, fk_invoke_async_free);
+    g_source_attach(source, frida_get_main_context());
+    g_source_unref(source);
+}
+
+// Attaches a timeout to the frida main context. The returned source is an
+// extra reference for the caller, for cancellation with g_source_destroy().
+GSource *fk_schedule(guint delay_ms, GSourceFunc func, gpointer user_data, GDestroyNotify notify) {
+    GSource *source = g_timeout_source_new(delay_ms);
+    g_source_set_callback(source, func, user_data, notify);
+    g_source_attach(source, frida_get_main_context());
+    return source;
+}
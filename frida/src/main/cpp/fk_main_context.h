@@ -0,0 +1,20 @@
+#ifndef __FK_MAIN_CONTEXT_H__
+#define __FK_MAIN_CONTEXT_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Runs func on the frida main context and waits for it to return. Signal
+// handlers and async callbacks run on that context too, so state touched only
+// from inside func needs no further locking against them. Calls made from the
+// main context itself run inline.
+typedef void (*FkMainContextFunc)(gpointer user_data);
+
+void fk_invoke_sync(FkMainContextFunc func, gpointer user_data);
+void fk_invoke_async(FkMainContextFunc func, gpointer user_data, GDestroyNotify notify);
+GSource *fk_schedule(guint delay_ms, GSourceFunc func, gpointer user_data, GDestroyNotify notify);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,257 @@
+#include "fk_marshal.h"
+
+void fk_write_application_list(FkWriter &writer, FridaApplicationList *list) {
+    gint size = frida_application_list_size(list);
+    writer.put_u32((guint32) size);
+    for (gint i = 0; i != size; i++) {
+        FridaApplication *application = frida_application_list_get(list, i);
+        writer.put_string(frida_application_get_identifier(application));
+        writer.put_string(frida_application_get_name(application));
+        writer.put_u32(frida_application_get_pid(application));
+        g_object_unref(application);
+    }
+}
+
+void fk_write_process_list(FkWriter &writer, FridaProcessList *list) {
+    gint size = frida_process_list_size(list);
+    writer.put_u32((guint32) size);
+    for (gint i = 0; i != size; i++) {
+        FridaProcess *process = frida_process_list_get(list, i);
+        writer.put_u32(frida_process_get_pid(process));
+        writer.put_string(frida_process_get_name(process));
+        g_object_unref(process);
+    }
+}
+
+void fk_write_child(FkWriter &writer, FridaChild *child) {
+    writer.put_u32(frida_child_get_pid(child));
+    writer.put_u32(frida_child_get_parent_pid(child));
+    writer.put_u8((guint8) frida_child_get_origin(child));
+    writer.put_string(frida_child_get_identifier(child));
+    writer.put_string(frida_child_get_path(child));
+
+    // Unowned: the child keeps its argv.
+    gint argc = 0;
+    gchar **argv = frida_child_get_argv(child, &argc);
+    writer.put_u32((guint32) argc);
+    for (gint i = 0; i != argc; i++)
+        writer.put_string(argv[i]);
+}
+
+// Dictionaries are any array of string-keyed entries (a{sv} in practice);
+// other containers are written as plain arrays of their children.
+void fk_write_variant(FkWriter &writer, GVariant *value) {
+    if (value == NULL) {
+        writer.put_u8(FK_VARIANT_NULL);
+        return;
+    }
+
+    switch (g_variant_classify(value)) {
+        case G_VARIANT_CLASS_STRING:
+        case G_VARIANT_CLASS_OBJECT_PATH:
+        case G_VARIANT_CLASS_SIGNATURE:
+            writer.put_u8(FK_VARIANT_STRING);
+            writer.put_string(g_variant_get_string(value, NULL));
+            return;
+        case G_VARIANT_CLASS_BOOLEAN:
+            writer.put_u8(FK_VARIANT_BOOLEAN);
+            writer.put_bool(g_variant_get_boolean(value));
+            return;
+        case G_VARIANT_CLASS_BYTE:
+            writer.put_u8(FK_VARIANT_INT64);
+            writer.put_i64(g_variant_get_byte(value));
+            return;
+        case G_VARIANT_CLASS_INT16:
+            writer.put_u8(FK_VARIANT_INT64);
+            writer.put_i64(g_variant_get_int16(value));
+            return;
+        case G_VARIANT_CLASS_UINT16:
+            writer.put_u8(FK_VARIANT_INT64);
+            writer.put_i64(g_variant_get_uint16(value));
+            return;
+        case G_VARIANT_CLASS_INT32:
+            writer.put_u8(FK_VARIANT_INT64);
+            writer.put_i64(g_variant_get_int32(value));
+            return;
+        case G_VARIANT_CLASS_UINT32:
+            writer.put_u8(FK_VARIANT_INT64);
+            writer.put_i64(g_variant_get_uint32(value));
+            return;
+        case G_VARIANT_CLASS_INT64:
+            writer.put_u8(FK_VARIANT_INT64);
+            writer.put_i64(g_variant_get_int64(value));
+            return;
+        case G_VARIANT_CLASS_UINT64:
+            writer.put_u8(FK_VARIANT_INT64);
+            writer.put_i64((gint64) g_variant_get_uint64(value));
+            return;
+        case G_VARIANT_CLASS_DOUBLE:
+            writer.put_u8(FK_VARIANT_DOUBLE);
+            writer.put_double(g_variant_get_double(value));
+            return;
+        case G_VARIANT_CLASS_VARIANT: {
+            GVariant *inner = g_variant_get_variant(value);
+            fk_write_variant(writer, inner);
+            g_variant_unref(inner);
+            return;
+        }
+        default:
+            break;
+    }
+
+    if (g_variant_is_of_type(value, G_VARIANT_TYPE_BYTESTRING)) {
+        gsize size;
+        gconstpointer data = g_variant_get_fixed_array(value, &size, 1);
+        writer.put_u8(FK_VARIANT_BYTES);
+        writer.put_bytes(data != NULL ? data : "", size);
+        return;
+    }
+
+    if (!g_variant_is_container(value)) {
+        writer.put_u8(FK_VARIANT_NULL);
+        return;
+    }
+
+    gsize count = g_variant_n_children(value);
+    gboolean is_dict = g_variant_is_of_type(value, G_VARIANT_TYPE("a{s*}"));
+    writer.put_u8(is_dict ? FK_VARIANT_DICT : FK_VARIANT_ARRAY);
+    writer.put_u32((guint32) count);
+    for (gsize i = 0; i != count; i++) {
+        GVariant *child = g_variant_get_child_value(value, i);
+        if (is_dict) {
+            GVariant *key = g_variant_get_child_value(child, 0);
+            GVariant *entry = g_variant_get_child_value(child, 1);
+            writer.put_string(g_variant_get_string(key, NULL));
+            fk_write_variant(writer, entry);
+            g_variant_unref(entry);
+            g_variant_unref(key);
+        } else {
+            fk_write_variant(writer, child);
+        }
+        g_variant_unref(child);
+    }
+}
+
+void fk_write_variant_dict(FkWriter &writer, GHashTable *dict) {
+    writer.put_u32(g_hash_table_size(dict));
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, dict);
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        writer.put_string((const gchar *) key);
+        fk_write_variant(writer, (GVariant *) value);
+    }
+}
+
+void fk_write_variant_dict_selected(FkWriter &writer, GHashTable *dict, const gchar * const *keys) {
+    if (keys == NULL) {
+        fk_write_variant_dict(writer, dict);
+        return;
+    }
+
+    gsize count_offset = writer.size();
+    guint32 count = 0;
+    writer.put_u32(0);
+    for (const gchar * const *key = keys; *key != NULL; key++) {
+        GVariant *value = (GVariant *) g_hash_table_lookup(dict, *key);
+        if (value == NULL)
+            continue;
+        writer.put_string(*key);
+        fk_write_variant(writer, value);
+        count++;
+    }
+    writer.patch_u32(count_offset, count);
+}
+
+void fk_write_application_list_with_parameters(FkWriter &writer, FridaApplicationList *list,
+                                               const gchar * const *keys) {
+    gint size = frida_application_list_size(list);
+    writer.put_u32((guint32) size);
+    for (gint i = 0; i != size; i++) {
+        FridaApplication *application = frida_application_list_get(list, i);
+        writer.put_string(frida_application_get_identifier(application));
+        writer.put_string(frida_application_get_name(application));
+        writer.put_u32(frida_application_get_pid(application));
+        fk_write_variant_dict_selected(writer, frida_application_get_parameters(application), keys);
+        g_object_unref(application);
+    }
+}
+
+void fk_write_process_list_with_parameters(FkWriter &writer, FridaProcessList *list, const gchar * const *keys) {
+    gint size = frida_process_list_size(list);
+    writer.put_u32((guint32) size);
+    for (gint i = 0; i != size; i++) {
+        FridaProcess *process = frida_process_list_get(list, i);
+        writer.put_u32(frida_process_get_pid(process));
+        writer.put_string(frida_process_get_name(process));
+        fk_write_variant_dict_selected(writer, frida_process_get_parameters(process), keys);
+        g_object_unref(process);
+    }
+}
+
+static GVariant *fk_read_variant_value(FkReader &reader, guint depth) {
+    if (depth > 64)
+        return NULL;
+
+    switch ((FkVariantType) reader.u8()) {
+        case FK_VARIANT_NULL:
+            return g_variant_new_maybe(G_VARIANT_TYPE_VARIANT, NULL);
+        case FK_VARIANT_STRING: {
+            gchar *value = reader.string();
+            return value != NULL ? g_variant_new_take_string(value) : NULL;
+        }
+        case FK_VARIANT_BOOLEAN:
+            return g_variant_new_boolean(reader.u8() != 0);
+        case FK_VARIANT_INT64:
+            return g_variant_new_int64(reader.i64());
+        case FK_VARIANT_DOUBLE:
+            return g_variant_new_double(reader.f64());
+        case FK_VARIANT_BYTES: {
+            gsize size;
+            gconstpointer data = reader.bytes(&size);
+            if (!reader.ok())
+                return NULL;
+            return g_variant_new_fixed_array(G_VARIANT_TYPE_BYTE, data != NULL ? data : "", size, 1);
+        }
+        case FK_VARIANT_DICT: {
+            guint32 count = reader.u32();
+            GVariantBuilder builder;
+            g_variant_builder_init(&builder, G_VARIANT_TYPE_VARDICT);
+            for (guint32 i = 0; i != count && reader.ok(); i++) {
+                gchar *key = reader.string();
+                GVariant *value = fk_read_variant_value(reader, depth + 1);
+                if (key != NULL && value != NULL)
+                    g_variant_builder_add(&builder, "{sv}", key, value);
+                else if (value != NULL)
+                    g_variant_unref(g_variant_ref_sink(value));
+                g_free(key);
+            }
+            return g_variant_builder_end(&builder);
+        }
+        case FK_VARIANT_ARRAY: {
+            guint32 count = reader.u32();
+            GVariantBuilder builder;
+            g_variant_builder_init(&builder, G_VARIANT_TYPE("av"));
+            for (guint32 i = 0; i != count && reader.ok(); i++) {
+                GVariant *value = fk_read_variant_value(reader, depth + 1);
+                if (value != NULL)
+                    g_variant_builder_add(&builder, "v", value);
+            }
+            return g_variant_builder_end(&builder);
+        }
+        default:
+            return NULL;
+    }
+}
+
+GVariant *fk_read_variant(FkReader &reader) {
+    GVariant *value = fk_read_variant_value(reader, 0);
+    if (value == NULL)
+        return NULL;
+    g_variant_ref_sink(value);
+    if (!reader.ok()) {
+        g_variant_unref(value);
+        return NULL;
+    }
+    return value;
+}
@@ -0,0 +1,46 @@
+#ifndef __FK_MARSHAL_H__
+#define __FK_MARSHAL_H__
+
+#include "frida_core.h"
+#include "fk_reader.h"
+#include "fk_writer.h"
+
+// Encoders for frida-core objects, shared by every helper that returns them.
+//   application list: u32 count, count x (string identifier, string name, u32 pid)
+//   process list:     u32 count, count x (u32 pid, string name)
+//   child:            u32 pid, u32 parent pid, u8 origin, string identifier,
+//                     string path, u32 argc, argc x string
+//   variant:          u8 FkVariantType, then per type: string | u8 | i64 |
+//                     double | blob | u32 count x (string key, variant) |
+//                     u32 count x variant; NULL carries no payload
+//   variant dict:     u32 count, count x (string key, variant)
+//   ... with parameters: the application/process entries above, each
+//                     followed by its parameters as a variant dict
+typedef enum {
+    FK_VARIANT_NULL,
+    FK_VARIANT_STRING,
+    FK_VARIANT_BOOLEAN,
+    FK_VARIANT_INT64,
+    FK_VARIANT_DOUBLE,
+    FK_VARIANT_BYTES,
+    FK_VARIANT_DICT,
+    FK_VARIANT_ARRAY
+} FkVariantType;
+
+void fk_write_application_list(FkWriter &writer, FridaApplicationList *list);
+void fk_write_process_list(FkWriter &writer, FridaProcessList *list);
+void fk_write_child(FkWriter &writer, FridaChild *child);
+void fk_write_variant(FkWriter &writer, GVariant *value);
+void fk_write_variant_dict(FkWriter &writer, GHashTable *dict);
+// keys is a NULL-terminated selection, or NULL for every key.
+void fk_write_variant_dict_selected(FkWriter &writer, GHashTable *dict, const gchar * const *keys);
+void fk_write_application_list_with_parameters(FkWriter &writer, FridaApplicationList *list,
+                                               const gchar * const *keys);
+void fk_write_process_list_with_parameters(FkWriter &writer, FridaProcessList *list, const gchar * const *keys);
+
+// The inverse of fk_write_variant, for values encoded on the Kotlin side.
+// Dicts become a{sv}, arrays av, and NULL an empty maybe; returns a new
+// (non-floating) ref, or NULL if the input is malformed.
+GVariant *fk_read_variant(FkReader &reader);
+
+#endif
@@ -0,0 +1,157 @@
+#include "fk_portal.h"
+#include "fk_main_context.h"
+#include "fk_writer.h"
+
+struct _FkPortal {
+    FridaPortalService *service;
+    FkEventQueue *events;
+    GArray *handlers;
+};
+
+static void fk_portal_push(FkPortal *self, FkWriter &writer) {
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_portal_begin(FkWriter &writer, FkPortalEvent kind, guint connection_id) {
+    writer.put_u8((guint8) kind);
+    writer.put_u32(connection_id);
+}
+
+static void fk_portal_push_address(FkPortal *self, FkPortalEvent kind, guint connection_id, GSocketAddress *address) {
+    FkWriter writer;
+    fk_portal_begin(writer, kind, connection_id);
+    gchar *description = address != NULL ? g_socket_connectable_to_string(G_SOCKET_CONNECTABLE(address)) : NULL;
+    writer.put_string(description);
+    g_free(description);
+    fk_portal_push(self, writer);
+}
+
+static void fk_portal_push_application(FkPortal *self, FkPortalEvent kind, guint connection_id,
+                                       FridaApplication *application) {
+    FkWriter writer;
+    fk_portal_begin(writer, kind, connection_id);
+    writer.put_string(frida_application_get_identifier(application));
+    writer.put_string(frida_application_get_name(application));
+    writer.put_u32(frida_application_get_pid(application));
+    fk_portal_push(self, writer);
+}
+
+static void fk_portal_on_node_connected(FridaPortalService *service, guint connection_id, GSocketAddress *address,
+                                        gpointer user_data) {
+    fk_portal_push_address((FkPortal *) user_data, FK_PORTAL_NODE_CONNECTED, connection_id, address);
+}
+
+static void fk_portal_on_node_joined(FridaPortalService *service, guint connection_id, FridaApplication *application,
+                                     gpointer user_data) {
+    fk_portal_push_application((FkPortal *) user_data, FK_PORTAL_NODE_JOINED, connection_id, application);
+}
+
+static void fk_portal_on_node_left(FridaPortalService *service, guint connection_id, FridaApplication *application,
+                                   gpointer user_data) {
+    fk_portal_push_application((FkPortal *) user_data, FK_PORTAL_NODE_LEFT, connection_id, application);
+}
+
+static void fk_portal_on_node_disconnected(FridaPortalService *service, guint connection_id, GSocketAddress *address,
+                                           gpointer user_data) {
+    fk_portal_push_address((FkPortal *) user_data, FK_PORTAL_NODE_DISCONNECTED, connection_id, address);
+}
+
+static void fk_portal_on_controller_connected(FridaPortalService *service, guint connection_id,
+                                              GSocketAddress *address, gpointer user_data) {
+    fk_portal_push_address((FkPortal *) user_data, FK_PORTAL_CONTROLLER_CONNECTED, connection_id, address);
+}
+
+static void fk_portal_on_controller_disconnected(FridaPortalService *service, guint connection_id,
+                                                 GSocketAddress *address, gpointer user_data) {
+    fk_portal_push_address((FkPortal *) user_data, FK_PORTAL_CONTROLLER_DISCONNECTED, connection_id, address);
+}
+
+static void fk_portal_on_authenticated(FridaPortalService *service, guint connection_id, const gchar *session_info,
+                                       gpointer user_data) {
+    FkWriter writer;
+    fk_portal_begin(writer, FK_PORTAL_AUTHENTICATED, connection_id);
+    writer.put_string(session_info);
+    fk_portal_push((FkPortal *) user_data, writer);
+}
+
+static void fk_portal_on_subscribe(FridaPortalService *service, guint connection_id, gpointer user_data) {
+    FkWriter writer;
+    fk_portal_begin(writer, FK_PORTAL_SUBSCRIBE, connection_id);
+    fk_portal_push((FkPortal *) user_data, writer);
+}
+
+static void fk_portal_on_message(FridaPortalService *service, guint connection_id, const gchar *json, GBytes *data,
+                                 gpointer user_data) {
+    FkWriter writer;
+    fk_portal_begin(writer, FK_PORTAL_MESSAGE, connection_id);
+    writer.put_string(json);
+    writer.put_gbytes(data);
+    fk_portal_push((FkPortal *) user_data, writer);
+}
+
+static void fk_portal_connect(FkPortal *self, const gchar *signal, GCallback handler) {
+    gulong id = g_signal_connect(self->service, signal, handler, self);
+    g_array_append_val(self->handlers, id);
+}
+
+FkPortal *fk_portal_new(FridaEndpointParameters *cluster_params, FridaEndpointParameters *control_params,
+                        guint queue_capacity) {
+    FkPortal *self = g_new0(FkPortal, 1);
+    self->service = frida_portal_service_new(cluster_params, control_params);
+    self->events = fk_event_queue_new(queue_capacity);
+    self->handlers = g_array_new(FALSE, FALSE, sizeof(gulong));
+
+    fk_portal_connect(self, "node-connected", G_CALLBACK(fk_portal_on_node_connected));
+    fk_portal_connect(self, "node-joined", G_CALLBACK(fk_portal_on_node_joined));
+    fk_portal_connect(self, "node-left", G_CALLBACK(fk_portal_on_node_left));
+    fk_portal_connect(self, "node-disconnected", G_CALLBACK(fk_portal_on_node_disconnected));
+    fk_portal_connect(self, "controller-connected", G_CALLBACK(fk_portal_on_controller_connected));
+    fk_portal_connect(self, "controller-disconnected", G_CALLBACK(fk_portal_on_controller_disconnected));
+    fk_portal_connect(self, "authenticated", G_CALLBACK(fk_portal_on_authenticated));
+    fk_portal_connect(self, "subscribe", G_CALLBACK(fk_portal_on_subscribe));
+    fk_portal_connect(self, "message", G_CALLBACK(fk_portal_on_message));
+
+    return self;
+}
+
+static void fk_portal_disconnect(gpointer user_data) {
+    FkPortal *self = (FkPortal *) user_data;
+    for (guint i = 0; i != self->handlers->len; i++)
+        g_signal_handler_disconnect(self->service, g_array_index(self->handlers, gulong, i));
+    g_array_set_size(self->handlers, 0);
+}
+
+void fk_portal_free(FkPortal *self) {
+    if (self == NULL)
+        return;
+    // Signals are emitted on the main context, so disconnecting there
+    // guarantees no handler is mid-flight once this returns.
+    fk_invoke_sync(fk_portal_disconnect, self);
+    fk_event_queue_close(self->events);
+    fk_event_queue_free(self->events);
+    g_array_free(self->handlers, TRUE);
+    g_object_unref(self->service);
+    g_free(self);
+}
+
+FridaPortalService *fk_portal_get_service(FkPortal *self) {
+    return self->service;
+}
+
+FkEventQueue *fk_portal_get_events(FkPortal *self) {
+    return self->events;
+}
+
+// u32 count, count x string tag
+GBytes *fk_portal_enumerate_tags(FkPortal *self, guint connection_id) {
+    gint length = 0;
+    gchar **tags = frida_portal_service_enumerate_tags(self->service, connection_id, &length);
+
+    FkWriter writer;
+    writer.put_u32((guint32) length);
+    for (gint i = 0; i != length; i++)
+        writer.put_string(tags[i]);
+    g_strfreev(tags);
+
+    return writer.steal();
+}
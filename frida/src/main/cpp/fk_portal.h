@@ -0,0 +1,40 @@
+#ifndef __FK_PORTAL_H__
+#define __FK_PORTAL_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Hosts a FridaPortalService and funnels all of its signals into one bounded
+// event queue. Every record starts with u8 FkPortalEvent, u32 connection id:
+//   NODE/CONTROLLER_CONNECTED/DISCONNECTED: string remote address
+//   NODE_JOINED/NODE_LEFT:                   string identifier, string name, u32 pid
+//   AUTHENTICATED:                           string session info
+//   SUBSCRIBE:                               (nothing)
+//   MESSAGE:                                 string json, blob data
+typedef struct _FkPortal FkPortal;
+
+typedef enum {
+    FK_PORTAL_NODE_CONNECTED,
+    FK_PORTAL_NODE_JOINED,
+    FK_PORTAL_NODE_LEFT,
+    FK_PORTAL_NODE_DISCONNECTED,
+    FK_PORTAL_CONTROLLER_CONNECTED,
+    FK_PORTAL_CONTROLLER_DISCONNECTED,
+    FK_PORTAL_AUTHENTICATED,
+    FK_PORTAL_SUBSCRIBE,
+    FK_PORTAL_MESSAGE
+} FkPortalEvent;
+
+FkPortal *fk_portal_new(FridaEndpointParameters *cluster_params, FridaEndpointParameters *control_params,
+                        guint queue_capacity);
+void fk_portal_free(FkPortal *self);
+
+FridaPortalService *fk_portal_get_service(FkPortal *self);
+FkEventQueue *fk_portal_get_events(FkPortal *self);
+GBytes *fk_portal_enumerate_tags(FkPortal *self, guint connection_id);
+
+G_END_DECLS
+
+#endif
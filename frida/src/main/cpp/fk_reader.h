@@ -0,0 +1,78 @@
+#ifndef __FK_READER_H__
+#define __FK_READER_H__
+
+#include "frida_core.h"
+
+// Decoder for records Kotlin encodes with dev.supersam.frida.NativeWriter,
+// the mirror of FkWriter. Reads past the end flag the reader as failed and
+// yield zeroes, so callers check ok() once at the end.
+class FkReader {
+public:
+    FkReader(gconstpointer data, gsize size)
+        : cursor((const guint8 *) data), end((const guint8 *) data + size), failed(FALSE) {}
+
+    gboolean ok() const {
+        return !failed;
+    }
+
+    guint8 u8() {
+        return take(1) ? cursor[-1] : 0;
+    }
+
+    guint32 u32() {
+        guint32 value = 0;
+        if (take(sizeof(value)))
+            memcpy(&value, cursor - sizeof(value), sizeof(value));
+        return GUINT32_FROM_LE(value);
+    }
+
+    gint64 i64() {
+        guint64 value = 0;
+        if (take(sizeof(value)))
+            memcpy(&value, cursor - sizeof(value), sizeof(value));
+        return (gint64) GUINT64_FROM_LE(value);
+    }
+
+    gdouble f64() {
+        guint64 raw = (guint64) i64();
+        gdouble value;
+        memcpy(&value, &raw, sizeof(value));
+        return value;
+    }
+
+    // Length-prefixed as written by FkWriter::put_bytes; points into the
+    // input. Returns NULL with *size 0 for the G_MAXUINT32 marker.
+    gconstpointer bytes(gsize *size) {
+        guint32 length = u32();
+        *size = 0;
+        if (failed || length == G_MAXUINT32 || !take(length))
+            return NULL;
+        *size = length;
+        return cursor - length;
+    }
+
+    gchar *string() {
+        gsize size;
+        gconstpointer data = bytes(&size);
+        return data != NULL ? g_strndup((const gchar *) data, size) : NULL;
+    }
+
+private:
+    const guint8 *cursor;
+    const guint8 *end;
+    gboolean failed;
+
+    gboolean take(gsize n) {
+        if (failed || (gsize) (end - cursor) < n) {
+            failed = TRUE;
+            return FALSE;
+        }
+        cursor += n;
+        return TRUE;
+    }
+
+    FkReader(const FkReader &);
+    FkReader &operator=(const FkReader &);
+};
+
+#endif
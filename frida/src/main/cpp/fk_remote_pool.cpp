@@ -0,0 +1,315 @@
+#include "fk_remote_pool.h"
+#include "fk_endpoint.h"
+#include "fk_main_context.h"
+#include "fk_writer.h"
+
+#define FK_REMOTE_RETRY_INITIAL_MS 500
+#define FK_REMOTE_RETRY_MAX_MS 30000
+
+typedef enum {
+    FK_REMOTE_CONNECTING,
+    FK_REMOTE_CONNECTED,
+    FK_REMOTE_RECONNECTING
+} FkRemoteState;
+
+struct FkRemoteEntry {
+    volatile gint ref_count;
+    FkRemotePool *pool;
+    gchar *address;
+    FridaRemoteDeviceOptions *options;
+    FridaDevice *device;
+    FkRemoteState state;
+    gulong lost_handler;
+    GSource *retry;
+    guint attempts;
+    gboolean removed;
+};
+
+struct _FkRemotePool {
+    FridaDeviceManager *manager;
+    GMutex lock;
+    GCond cond;
+    GHashTable *entries;
+    FkEventQueue *events;
+};
+
+static void fk_remote_entry_connect(FkRemoteEntry *entry);
+
+static FkRemoteEntry *fk_remote_entry_ref(FkRemoteEntry *entry) {
+    g_atomic_int_inc(&entry->ref_count);
+    return entry;
+}
+
+static void fk_remote_entry_unref(gpointer data) {
+    FkRemoteEntry *entry = (FkRemoteEntry *) data;
+    if (!g_atomic_int_dec_and_test(&entry->ref_count))
+        return;
+    if (entry->device != NULL)
+        g_object_unref(entry->device);
+    g_object_unref(entry->options);
+    g_free(entry->address);
+    g_free(entry);
+}
+
+static void fk_remote_pool_publish(FkRemotePool *self, FkRemoteEvent kind, FkRemoteEntry *entry, const gchar *error) {
+    FkWriter writer;
+    writer.put_u8((guint8) kind);
+    writer.put_string(entry->address);
+    writer.put_string(entry->device != NULL ? frida_device_get_id(entry->device) : NULL);
+    writer.put_u32(entry->attempts);
+    writer.put_string(error);
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_remote_entry_on_lost(FridaDevice *device, gpointer user_data) {
+    FkRemoteEntry *entry = (FkRemoteEntry *) user_data;
+    FkRemotePool *self = entry->pool;
+
+    g_signal_handler_disconnect(device, entry->lost_handler);
+    entry->lost_handler = 0;
+
+    g_mutex_lock(&self->lock);
+    entry->state = FK_REMOTE_RECONNECTING;
+    entry->attempts = 0;
+    g_mutex_unlock(&self->lock);
+
+    fk_remote_pool_publish(self, FK_REMOTE_LOST, entry, NULL);
+    fk_remote_entry_connect(entry);
+}
+
+// Runs on the frida main context, where "lost" is emitted, so a device that
+// went away before we got here is caught by the check below rather than missed.
+static void fk_remote_entry_watch(FkRemoteEntry *entry) {
+    entry->lost_handler = g_signal_connect(entry->device, "lost", G_CALLBACK(fk_remote_entry_on_lost), entry);
+    if (frida_device_is_lost(entry->device))
+        fk_remote_entry_on_lost(entry->device, entry);
+}
+
+static void fk_remote_entry_on_orphan_removed(GObject *source, GAsyncResult *result, gpointer user_data) {
+    frida_device_manager_remove_remote_device_finish((FridaDeviceManager *) source, result, NULL);
+}
+
+static void fk_remote_entry_on_reconnected(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkRemoteEntry *entry = (FkRemoteEntry *) user_data;
+    FkRemotePool *self = entry->pool;
+    GError *error = NULL;
+
+    FridaDevice *device = frida_device_manager_add_remote_device_finish((FridaDeviceManager *) source, result, &error);
+
+    // Pool membership is re-checked under the lock: remove() may have run
+    // while the attempt was in flight, and its remove_remote_device() then
+    // went out before this device was added to the manager.
+    g_mutex_lock(&self->lock);
+    gboolean removed = entry->removed;
+    if (!removed && device != NULL) {
+        if (entry->device != NULL)
+            g_object_unref(entry->device);
+        entry->device = device;
+        entry->state = FK_REMOTE_CONNECTED;
+        g_cond_broadcast(&self->cond);
+    }
+    g_mutex_unlock(&self->lock);
+
+    if (removed) {
+        if (device != NULL) {
+            frida_device_manager_remove_remote_device(self->manager, entry->address, NULL,
+                                                      fk_remote_entry_on_orphan_removed, NULL);
+            g_object_unref(device);
+        }
+        g_clear_error(&error);
+        fk_remote_entry_unref(entry);
+        return;
+    }
+
+    if (device != NULL) {
+        fk_remote_pool_publish(self, FK_REMOTE_RECONNECTED, entry, NULL);
+        entry->attempts = 0;
+        fk_remote_entry_watch(entry);
+    } else {
+        fk_remote_pool_publish(self, FK_REMOTE_RECONNECT_FAILED, entry, error->message);
+        g_error_free(error);
+        fk_remote_entry_connect(entry);
+    }
+
+    fk_remote_entry_unref(entry);
+}
+
+static gboolean fk_remote_entry_on_retry(gpointer user_data) {
+    FkRemoteEntry *entry = (FkRemoteEntry *) user_data;
+
+    g_source_unref(entry->retry);
+    entry->retry = NULL;
+
+    frida_device_manager_add_remote_device(entry->pool->manager, entry->address, entry->options, NULL,
+                                           fk_remote_entry_on_reconnected, fk_remote_entry_ref(entry));
+    return G_SOURCE_REMOVE;
+}
+
+// Schedules the next reconnect attempt; runs on the frida main context.
+static void fk_remote_entry_connect(FkRemoteEntry *entry) {
+    guint delay = FK_REMOTE_RETRY_INITIAL_MS;
+    for (guint i = 0; i != entry->attempts && delay < FK_REMOTE_RETRY_MAX_MS; i++)
+        delay *= 2;
+    entry->attempts++;
+
+    entry->retry = fk_schedule(MIN(delay, FK_REMOTE_RETRY_MAX_MS), fk_remote_entry_on_retry, entry, NULL);
+}
+
+static void fk_remote_entry_teardown(gpointer user_data) {
+    FkRemoteEntry *entry = (FkRemoteEntry *) user_data;
+
+    if (entry->lost_handler != 0) {
+        g_signal_handler_disconnect(entry->device, entry->lost_handler);
+        entry->lost_handler = 0;
+    }
+    if (entry->retry != NULL) {
+        g_source_destroy(entry->retry);
+        g_source_unref(entry->retry);
+        entry->retry = NULL;
+    }
+}
+
+static void fk_remote_entry_start_watching(gpointer user_data) {
+    FkRemoteEntry *entry = (FkRemoteEntry *) user_data;
+    if (!entry->removed)
+        fk_remote_entry_watch(entry);
+}
+
+FkRemotePool *fk_remote_pool_new(FridaDeviceManager *manager) {
+    FkRemotePool *self = g_new0(FkRemotePool, 1);
+    self->manager = (FridaDeviceManager *) g_object_ref(manager);
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+    self->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, fk_remote_entry_unref);
+    self->events = fk_event_queue_new(0);
+    return self;
+}
+
+void fk_remote_pool_free(FkRemotePool *self) {
+    if (self == NULL)
+        return;
+
+    GList *addresses = g_hash_table_get_keys(self->entries);
+    for (GList *cur = addresses; cur != NULL; cur = cur->next) {
+        gchar *address = g_strdup((const gchar *) cur->data);
+        fk_remote_pool_remove(self, address, NULL);
+        g_free(address);
+    }
+    g_list_free(addresses);
+
+    fk_event_queue_close(self->events);
+    fk_event_queue_free(self->events);
+    g_hash_table_unref(self->entries);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+    g_object_unref(self->manager);
+    g_free(self);
+}
+
+// Returns a new reference to the device for address, connecting it the first
+// time. Concurrent callers for the same address share one connection attempt.
+FridaDevice *fk_remote_pool_add(FkRemotePool *self, const gchar *address, const gchar *certificate,
+                                const gchar *origin, const gchar *token, gint keepalive_interval, GError **error) {
+    g_mutex_lock(&self->lock);
+
+    FkRemoteEntry *entry = (FkRemoteEntry *) g_hash_table_lookup(self->entries, address);
+    if (entry != NULL) {
+        fk_remote_entry_ref(entry);
+        while (entry->state == FK_REMOTE_CONNECTING && !entry->removed)
+            g_cond_wait(&self->cond, &self->lock);
+
+        FridaDevice *device = NULL;
+        if (entry->state == FK_REMOTE_CONNECTED && !entry->removed)
+            device = (FridaDevice *) g_object_ref(entry->device);
+        else
+            g_set_error(error, FRIDA_ERROR, FRIDA_ERROR_TRANSPORT, "Connection to %s is not available", address);
+        g_mutex_unlock(&self->lock);
+
+        fk_remote_entry_unref(entry);
+        return device;
+    }
+
+    FridaRemoteDeviceOptions *options = frida_remote_device_options_new();
+    if (certificate != NULL) {
+        GTlsCertificate *tls = fk_tls_certificate_parse(certificate, error);
+        if (tls == NULL) {
+            g_mutex_unlock(&self->lock);
+            g_object_unref(options);
+            return NULL;
+        }
+        frida_remote_device_options_set_certificate(options, tls);
+        g_object_unref(tls);
+    }
+    if (origin != NULL)
+        frida_remote_device_options_set_origin(options, origin);
+    if (token != NULL)
+        frida_remote_device_options_set_token(options, token);
+    frida_remote_device_options_set_keepalive_interval(options, keepalive_interval);
+
+    entry = g_new0(FkRemoteEntry, 1);
+    entry->ref_count = 1;
+    entry->pool = self;
+    entry->address = g_strdup(address);
+    entry->options = options;
+    entry->state = FK_REMOTE_CONNECTING;
+    g_hash_table_insert(self->entries, entry->address, fk_remote_entry_ref(entry));
+
+    g_mutex_unlock(&self->lock);
+
+    FridaDevice *device = frida_device_manager_add_remote_device_sync(self->manager, address, options, NULL, error);
+
+    g_mutex_lock(&self->lock);
+    if (device != NULL && entry->removed) {
+        g_mutex_unlock(&self->lock);
+        frida_device_manager_remove_remote_device_sync(self->manager, address, NULL, NULL);
+        g_object_unref(device);
+        g_set_error(error, FRIDA_ERROR, FRIDA_ERROR_INVALID_OPERATION, "%s was removed while connecting", address);
+        fk_remote_entry_unref(entry);
+        return NULL;
+    } else if (device != NULL) {
+        entry->device = (FridaDevice *) g_object_ref(device);
+        entry->state = FK_REMOTE_CONNECTED;
+    } else if (!entry->removed) {
+        entry->removed = TRUE;
+        g_hash_table_remove(self->entries, address);
+    }
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    if (device != NULL)
+        fk_invoke_sync(fk_remote_entry_start_watching, entry);
+
+    fk_remote_entry_unref(entry);
+    return device;
+}
+
+void fk_remote_pool_remove(FkRemotePool *self, const gchar *address, GError **error) {
+    gpointer key, value;
+
+    g_mutex_lock(&self->lock);
+    gboolean found = g_hash_table_steal_extended(self->entries, address, &key, &value);
+    if (found)
+        ((FkRemoteEntry *) value)->removed = TRUE;
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    if (!found)
+        return;
+
+    FkRemoteEntry *entry = (FkRemoteEntry *) value;
+    fk_invoke_sync(fk_remote_entry_teardown, entry);
+
+    GError *remove_error = NULL;
+    frida_device_manager_remove_remote_device_sync(self->manager, address, NULL, &remove_error);
+    // A lost device has already left the manager; that is not a failure here.
+    if (remove_error != NULL && entry->state == FK_REMOTE_CONNECTED)
+        g_propagate_error(error, remove_error);
+    else
+        g_clear_error(&remove_error);
+
+    fk_remote_entry_unref(entry);
+}
+
+FkEventQueue *fk_remote_pool_get_events(FkRemotePool *self) {
+    return self->events;
+}
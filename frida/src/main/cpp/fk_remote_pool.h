@@ -0,0 +1,31 @@
+#ifndef __FK_REMOTE_POOL_H__
+#define __FK_REMOTE_POOL_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Connects each remote address at most once and hands the same FridaDevice to
+// every caller. When a device is lost the pool reconnects in the background
+// with exponential backoff, publishing records on the event queue:
+//   u8 FkRemoteEvent, string address, string device id, u32 attempt, string error
+typedef struct _FkRemotePool FkRemotePool;
+
+typedef enum {
+    FK_REMOTE_LOST,
+    FK_REMOTE_RECONNECTED,
+    FK_REMOTE_RECONNECT_FAILED
+} FkRemoteEvent;
+
+FkRemotePool *fk_remote_pool_new(FridaDeviceManager *manager);
+void fk_remote_pool_free(FkRemotePool *self);
+
+FridaDevice *fk_remote_pool_add(FkRemotePool *self, const gchar *address, const gchar *certificate,
+                                const gchar *origin, const gchar *token, gint keepalive_interval, GError **error);
+void fk_remote_pool_remove(FkRemotePool *self, const gchar *address, GError **error);
+FkEventQueue *fk_remote_pool_get_events(FkRemotePool *self);
+
+G_END_DECLS
+
+#endif
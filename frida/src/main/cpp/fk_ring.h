@@ -0,0 +1,76 @@
+#ifndef __FK_RING_H__
+#define __FK_RING_H__
+
+#include "frida_core.h"
+
+// Fixed-capacity byte ring. Not thread-safe on its own; callers lock. The
+// span accessors expose the contiguous readable/writable regions so streams
+// can read and write straight in and out of the ring; consuming never moves
+// the tail, so a writable span stays valid while readers drain.
+class FkRing {
+public:
+    explicit FkRing(gsize capacity)
+        : bytes((guint8 *) g_malloc(MAX(capacity, 1))), capacity(MAX(capacity, 1)), head(0), length(0) {}
+
+    ~FkRing() {
+        g_free(bytes);
+    }
+
+    gsize size() const {
+        return length;
+    }
+
+    gsize space() const {
+        return capacity - length;
+    }
+
+    gsize put(const guint8 *data, gsize size) {
+        gsize n = MIN(size, space());
+        gsize tail = (head + length) % capacity;
+        gsize first = MIN(n, capacity - tail);
+        memcpy(bytes + tail, data, first);
+        memcpy(bytes, data + first, n - first);
+        length += n;
+        return n;
+    }
+
+    gsize take(guint8 *buffer, gsize size) {
+        gsize n = MIN(size, length);
+        gsize first = MIN(n, capacity - head);
+        memcpy(buffer, bytes + head, first);
+        memcpy(buffer + first, bytes, n - first);
+        consume(n);
+        return n;
+    }
+
+    gsize readable(const guint8 **span) const {
+        *span = bytes + head;
+        return MIN(length, capacity - head);
+    }
+
+    void consume(gsize n) {
+        head = (head + n) % capacity;
+        length -= n;
+    }
+
+    gsize writable(guint8 **span) {
+        gsize tail = (head + length) % capacity;
+        *span = bytes + tail;
+        return tail >= head && length != capacity ? capacity - tail : head - tail;
+    }
+
+    void commit(gsize n) {
+        length += n;
+    }
+
+private:
+    guint8 *bytes;
+    gsize capacity;
+    gsize head;
+    gsize length;
+
+    FkRing(const FkRing &);
+    FkRing &operator=(const FkRing &);
+};
+
+#endif
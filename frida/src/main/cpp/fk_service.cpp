@@ -0,0 +1,153 @@
+#include "fk_service.h"
+#include "fk_main_context.h"
+#include "fk_marshal.h"
+
+struct _FkService {
+    volatile gint ref_count;
+    FridaService *service;
+    FkEventQueue *events;
+    GCancellable *cancellable;
+    volatile gint next_request;
+    gulong message_handler;
+    gulong close_handler;
+};
+
+struct FkServiceRequest {
+    FkService *service;
+    guint id;
+    GVariant *parameters;
+};
+
+static FkService *fk_service_ref(FkService *self) {
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+static void fk_service_unref(FkService *self) {
+    if (!g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+    fk_event_queue_free(self->events);
+    g_object_unref(self->cancellable);
+    g_object_unref(self->service);
+    g_free(self);
+}
+
+static void fk_service_on_message(FridaService *service, GVariant *message, gpointer user_data) {
+    FkService *self = (FkService *) user_data;
+    FkWriter writer;
+    writer.put_u8(FK_SERVICE_MESSAGE);
+    fk_write_variant(writer, message);
+    fk_event_queue_push(self->events, writer.data(), writer.size());
+}
+
+static void fk_service_on_close(FridaService *service, gpointer user_data) {
+    FkService *self = (FkService *) user_data;
+    guint8 kind = FK_SERVICE_CLOSED;
+    fk_event_queue_push(self->events, &kind, 1);
+}
+
+static void fk_service_connect(gpointer user_data) {
+    FkService *self = (FkService *) user_data;
+    self->message_handler = g_signal_connect(self->service, "message", G_CALLBACK(fk_service_on_message), self);
+    self->close_handler = g_signal_connect(self->service, "close", G_CALLBACK(fk_service_on_close), self);
+}
+
+static void fk_service_disconnect(gpointer user_data) {
+    FkService *self = (FkService *) user_data;
+    g_signal_handler_disconnect(self->service, self->message_handler);
+    g_signal_handler_disconnect(self->service, self->close_handler);
+}
+
+FkService *fk_service_open_sync(FridaDevice *device, const gchar *address, GError **error) {
+    FridaService *service = frida_device_open_service_sync(device, address, NULL, error);
+    if (service == NULL)
+        return NULL;
+
+    FkService *self = g_new0(FkService, 1);
+    self->ref_count = 1;
+    self->service = service;
+    self->events = fk_event_queue_new(0);
+    self->cancellable = g_cancellable_new();
+
+    fk_invoke_sync(fk_service_connect, self);
+
+    GError *local_error = NULL;
+    frida_service_activate_sync(service, NULL, &local_error);
+    if (local_error != NULL) {
+        g_propagate_error(error, local_error);
+        fk_service_free(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+// Pending requests complete as cancelled and keep the service alive until
+// they have.
+void fk_service_free(FkService *self) {
+    if (self == NULL)
+        return;
+    g_cancellable_cancel(self->cancellable);
+    fk_invoke_sync(fk_service_disconnect, self);
+    frida_service_cancel_sync(self->service, NULL, NULL);
+    fk_event_queue_close(self->events);
+    fk_service_unref(self);
+}
+
+static void fk_service_on_response(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkServiceRequest *request = (FkServiceRequest *) user_data;
+    GError *error = NULL;
+    GVariant *response = frida_service_request_finish(FRIDA_SERVICE(source), result, &error);
+
+    FkWriter writer;
+    if (error == NULL) {
+        writer.put_u8(FK_SERVICE_RESPONSE);
+        writer.put_u32(request->id);
+        fk_write_variant(writer, response);
+        g_variant_unref(response);
+    } else {
+        writer.put_u8(FK_SERVICE_FAILED);
+        writer.put_u32(request->id);
+        writer.put_string(error->message);
+        g_error_free(error);
+    }
+    fk_event_queue_push(request->service->events, writer.data(), writer.size());
+
+    fk_service_unref(request->service);
+    g_free(request);
+}
+
+static void fk_service_start_request(gpointer user_data) {
+    FkServiceRequest *request = (FkServiceRequest *) user_data;
+    GVariant *parameters = request->parameters;
+    request->parameters = NULL;
+    frida_service_request(request->service->service, parameters, request->service->cancellable,
+                          fk_service_on_response, request);
+    g_variant_unref(parameters);
+}
+
+guint fk_service_request(FkService *self, gconstpointer buffer, gsize size, GError **error) {
+    FkReader reader(buffer, size);
+    GVariant *parameters = fk_read_variant(reader);
+    if (parameters == NULL) {
+        g_set_error_literal(error, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT, "Malformed request parameters");
+        return 0;
+    }
+
+    FkServiceRequest *request = g_new0(FkServiceRequest, 1);
+    request->service = fk_service_ref(self);
+    request->id = (guint) g_atomic_int_add(&self->next_request, 1) + 1;
+    request->parameters = parameters;
+
+    guint id = request->id;
+    fk_invoke_async(fk_service_start_request, request, NULL);
+    return id;
+}
+
+gboolean fk_service_is_closed(FkService *self) {
+    return frida_service_is_closed(self->service);
+}
+
+FkEventQueue *fk_service_get_events(FkService *self) {
+    return self->events;
+}
@@ -0,0 +1,37 @@
+#ifndef __FK_SERVICE_H__
+#define __FK_SERVICE_H__
+
+#include "frida_core.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// A platform service (frida_device_open_service_sync, e.g. "xpc:...") with
+// pipelined requests. fk_service_request decodes the parameters (a variant
+// as written by NativeWriter) and starts the request on the frida main
+// context without waiting, so any number can be in flight. Completions and
+// service messages are published on one unbounded queue:
+//   FK_SERVICE_RESPONSE: u8 kind, u32 request id, variant
+//   FK_SERVICE_FAILED:   u8 kind, u32 request id, string error
+//   FK_SERVICE_MESSAGE:  u8 kind, variant
+//   FK_SERVICE_CLOSED:   u8 kind
+typedef struct _FkService FkService;
+
+typedef enum {
+    FK_SERVICE_RESPONSE,
+    FK_SERVICE_FAILED,
+    FK_SERVICE_MESSAGE,
+    FK_SERVICE_CLOSED
+} FkServiceEvent;
+
+FkService *fk_service_open_sync(FridaDevice *device, const gchar *address, GError **error);
+void fk_service_free(FkService *self);
+
+// Returns the request id its completion will carry.
+guint fk_service_request(FkService *self, gconstpointer buffer, gsize size, GError **error);
+gboolean fk_service_is_closed(FkService *self);
+FkEventQueue *fk_service_get_events(FkService *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,46 @@
+#include "fk_session.h"
+
+static G_DEFINE_QUARK(fk-session-peer, fk_session_peer)
+
+FridaPeerOptions *fk_peer_options_new(const gchar *stun_server) {
+    FridaPeerOptions *options = frida_peer_options_new();
+    if (stun_server != NULL)
+        frida_peer_options_set_stun_server(options, stun_server);
+    return options;
+}
+
+void fk_peer_options_add_relay(FridaPeerOptions *options, const gchar *address, const gchar *username,
+                               const gchar *password, FridaRelayKind kind) {
+    FridaRelay *relay = frida_relay_new(address, username, password, kind);
+    frida_peer_options_add_relay(options, relay);
+    g_object_unref(relay);
+}
+
+// Completes a frida_session_setup_peer_connection started on the main context.
+gboolean fk_session_setup_peer_connection_finish(FridaSession *session, GAsyncResult *result, GError **error) {
+    GError *local_error = NULL;
+    frida_session_setup_peer_connection_finish(session, result, &local_error);
+    if (local_error != NULL) {
+        g_propagate_error(error, local_error);
+        return FALSE;
+    }
+    g_object_set_qdata(G_OBJECT(session), fk_session_peer_quark(), GINT_TO_POINTER(TRUE));
+    return TRUE;
+}
+
+void fk_session_setup_peer_connection_sync(FridaSession *session, FridaPeerOptions *options, GError **error) {
+    GError *local_error = NULL;
+    frida_session_setup_peer_connection_sync(session, options, NULL, &local_error);
+    if (local_error != NULL) {
+        g_propagate_error(error, local_error);
+        return;
+    }
+    g_object_set_qdata(G_OBJECT(session), fk_session_peer_quark(), GINT_TO_POINTER(TRUE));
+}
+
+FkSessionTransport fk_session_get_transport(FridaSession *session) {
+    if (frida_session_is_detached(session))
+        return FK_SESSION_TRANSPORT_DETACHED;
+    return g_object_get_qdata(G_OBJECT(session), fk_session_peer_quark()) != NULL ? FK_SESSION_TRANSPORT_PEER
+                                                                                 : FK_SESSION_TRANSPORT_CONTROL;
+}
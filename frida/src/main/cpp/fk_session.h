@@ -0,0 +1,27 @@
+#ifndef __FK_SESSION_H__
+#define __FK_SESSION_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Peer connection setup that remembers its outcome on the session, since
+// frida itself does not say whether traffic still goes through the control
+// channel or over the direct peer connection.
+typedef enum {
+    FK_SESSION_TRANSPORT_CONTROL,
+    FK_SESSION_TRANSPORT_PEER,
+    FK_SESSION_TRANSPORT_DETACHED
+} FkSessionTransport;
+
+FridaPeerOptions *fk_peer_options_new(const gchar *stun_server);
+void fk_peer_options_add_relay(FridaPeerOptions *options, const gchar *address, const gchar *username,
+                               const gchar *password, FridaRelayKind kind);
+
+gboolean fk_session_setup_peer_connection_finish(FridaSession *session, GAsyncResult *result, GError **error);
+void fk_session_setup_peer_connection_sync(FridaSession *session, FridaPeerOptions *options, GError **error);
+FkSessionTransport fk_session_get_transport(FridaSession *session);
+
+G_END_DECLS
+
+#endif
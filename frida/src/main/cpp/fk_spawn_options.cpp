@@ -0,0 +1,146 @@
+#include "fk_spawn_options.h"
+
+class FkSpawnOptionsParser {
+public:
+    FkSpawnOptionsParser(gconstpointer buffer, gsize size)
+        : cursor((const gchar *) buffer), end((const gchar *) buffer + size), failed(FALSE) {}
+
+    gboolean ok() const {
+        return !failed;
+    }
+
+    void fail() {
+        failed = TRUE;
+    }
+
+    guint32 u32() {
+        guint32 value = 0;
+        if (!take(sizeof(value)))
+            return 0;
+        memcpy(&value, cursor - sizeof(value), sizeof(value));
+        return GUINT32_FROM_LE(value);
+    }
+
+    guint8 u8() {
+        return take(1) ? (guint8) cursor[-1] : 0;
+    }
+
+    gint64 i64() {
+        guint64 value = 0;
+        if (!take(sizeof(value)))
+            return 0;
+        memcpy(&value, cursor - sizeof(value), sizeof(value));
+        return (gint64) GUINT64_FROM_LE(value);
+    }
+
+    // Points into the buffer; valid for as long as the caller's buffer is.
+    gchar *cstring() {
+        if (failed)
+            return NULL;
+        const gchar *terminator = (const gchar *) memchr(cursor, '\0', end - cursor);
+        if (terminator == NULL) {
+            failed = TRUE;
+            return NULL;
+        }
+        gchar *value = (gchar *) cursor;
+        cursor = terminator + 1;
+        return value;
+    }
+
+    gchar **vector(gint *length) {
+        guint32 count = u32();
+        if (failed || count > (guint32) (end - cursor)) {
+            failed = TRUE;
+            return NULL;
+        }
+        gchar **result = g_new(gchar *, count + 1);
+        for (guint32 i = 0; i != count; i++)
+            result[i] = cstring();
+        result[count] = NULL;
+        *length = (gint) count;
+        return result;
+    }
+
+private:
+    const gchar *cursor;
+    const gchar *end;
+    gboolean failed;
+
+    gboolean take(gsize n) {
+        if (failed || (gsize) (end - cursor) < n) {
+            failed = TRUE;
+            return FALSE;
+        }
+        cursor += n;
+        return TRUE;
+    }
+};
+
+static void fk_spawn_options_set_vector(FridaSpawnOptions *options, FkSpawnOptionsParser &parser,
+                                        void (*setter)(FridaSpawnOptions *, gchar **, gint)) {
+    gint length = 0;
+    // Only the vector itself is allocated; its elements borrow the buffer.
+    gchar **vector = parser.vector(&length);
+    if (parser.ok())
+        setter(options, vector, length);
+    g_free(vector);
+}
+
+FridaSpawnOptions *fk_spawn_options_new(gconstpointer buffer, gsize size, GError **error) {
+    FkSpawnOptionsParser parser(buffer, size);
+    FridaSpawnOptions *options = frida_spawn_options_new();
+
+    guint32 fields = parser.u32();
+
+    if ((fields & FK_SPAWN_ARGV) != 0)
+        fk_spawn_options_set_vector(options, parser, frida_spawn_options_set_argv);
+    if ((fields & FK_SPAWN_ENVP) != 0)
+        fk_spawn_options_set_vector(options, parser, frida_spawn_options_set_envp);
+    if ((fields & FK_SPAWN_ENV) != 0)
+        fk_spawn_options_set_vector(options, parser, frida_spawn_options_set_env);
+    if ((fields & FK_SPAWN_CWD) != 0) {
+        const gchar *cwd = parser.cstring();
+        if (parser.ok())
+            frida_spawn_options_set_cwd(options, cwd);
+    }
+    if ((fields & FK_SPAWN_STDIO) != 0)
+        frida_spawn_options_set_stdio(options, (FridaStdio) parser.u32());
+    if ((fields & FK_SPAWN_AUX) != 0) {
+        GHashTable *aux = frida_spawn_options_get_aux(options);
+        guint32 count = parser.u32();
+        for (guint32 i = 0; i != count && parser.ok(); i++) {
+            const gchar *key = parser.cstring();
+            GVariant *value = NULL;
+            switch ((FkAuxType) parser.u8()) {
+                case FK_AUX_STRING: {
+                    const gchar *string = parser.cstring();
+                    value = g_variant_new_string(string != NULL ? string : "");
+                    break;
+                }
+                case FK_AUX_BOOLEAN:
+                    value = g_variant_new_boolean(parser.u8() != 0);
+                    break;
+                case FK_AUX_INT64:
+                    value = g_variant_new_int64(parser.i64());
+                    break;
+                default:
+                    // The payload size is unknown, so nothing after it can be
+                    // trusted either.
+                    parser.fail();
+                    break;
+            }
+            if (parser.ok() && key != NULL && value != NULL)
+                g_hash_table_insert(aux, g_strdup(key), g_variant_ref_sink(value));
+            else if (value != NULL)
+                g_variant_unref(g_variant_ref_sink(value));
+        }
+    }
+
+    if (!parser.ok()) {
+        g_object_unref(options);
+        g_set_error_literal(error, FRIDA_ERROR, FRIDA_ERROR_INVALID_ARGUMENT, "Malformed spawn options");
+        return NULL;
+    }
+
+    return options;
+}
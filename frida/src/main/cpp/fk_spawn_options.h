@@ -0,0 +1,37 @@
+#ifndef __FK_SPAWN_OPTIONS_H__
+#define __FK_SPAWN_OPTIONS_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Builds FridaSpawnOptions from one packed buffer written by the Kotlin
+// SpawnOptions class. All strings are NUL-terminated in place and the gchar*
+// vectors handed to frida point straight into the buffer, so nothing is
+// duplicated on this side. Layout (little-endian):
+//   u32 FkSpawnField mask
+//   ARGV, ENVP, ENV:  u32 count, count x cstring
+//   CWD:              cstring
+//   STDIO:            u32 FridaStdio
+//   AUX:              u32 count, count x (cstring key, u8 FkAuxType, value)
+//                     where value is a cstring, u8 or i64
+typedef enum {
+    FK_SPAWN_ARGV = 1 << 0,
+    FK_SPAWN_ENVP = 1 << 1,
+    FK_SPAWN_ENV = 1 << 2,
+    FK_SPAWN_CWD = 1 << 3,
+    FK_SPAWN_STDIO = 1 << 4,
+    FK_SPAWN_AUX = 1 << 5
+} FkSpawnField;
+
+typedef enum {
+    FK_AUX_STRING,
+    FK_AUX_BOOLEAN,
+    FK_AUX_INT64
+} FkAuxType;
+
+FridaSpawnOptions *fk_spawn_options_new(gconstpointer buffer, gsize size, GError **error);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,205 @@
+#include "fk_spawn_pipeline.h"
+#include "fk_main_context.h"
+#include "fk_writer.h"
+
+struct _FkSpawnPipeline {
+    volatile gint ref_count;
+    FridaDevice *device;
+    FkAgent *agent;
+    GHashTable *identifiers;
+    GHashTable *in_flight;
+    FkEventQueue *events;
+    gulong spawn_added_handler;
+    gboolean running;
+};
+
+struct FkSpawnJob {
+    FkSpawnPipeline *pipeline;
+    guint pid;
+    gchar *identifier;
+    gint64 started;
+};
+
+static FkSpawnPipeline *fk_spawn_pipeline_ref(FkSpawnPipeline *self) {
+    g_atomic_int_inc(&self->ref_count);
+    return self;
+}
+
+static void fk_spawn_pipeline_unref(FkSpawnPipeline *self) {
+    if (!g_atomic_int_dec_and_test(&self->ref_count))
+        return;
+    fk_event_queue_free(self->events);
+    g_hash_table_unref(self->in_flight);
+    g_hash_table_unref(self->identifiers);
+    fk_agent_unref(self->agent);
+    g_object_unref(self->device);
+    g_free(self);
+}
+
+static void fk_spawn_pipeline_publish(FkSpawnJob *job, FkSpawnEvent kind, const gchar *error) {
+    FkWriter writer;
+    writer.put_u8((guint8) kind);
+    writer.put_u32(job->pid);
+    writer.put_string(job->identifier);
+    writer.put_string(error);
+    writer.put_i64(g_get_monotonic_time() - job->started);
+    fk_event_queue_push(job->pipeline->events, writer.data(), writer.size());
+}
+
+static void fk_spawn_job_free(FkSpawnJob *job) {
+    g_hash_table_remove(job->pipeline->in_flight, GUINT_TO_POINTER(job->pid));
+    fk_spawn_pipeline_unref(job->pipeline);
+    g_free(job->identifier);
+    g_free(job);
+}
+
+static void fk_spawn_pipeline_on_resumed(GObject *source, GAsyncResult *result, gpointer user_data) {
+    FkSpawnJob *job = (FkSpawnJob *) user_data;
+    GError *error = NULL;
+
+    frida_device_resume_finish((FridaDevice *) source, result, &error);
+    if (error == NULL) {
+        fk_spawn_pipeline_publish(job, FK_SPAWN_RESUMED, NULL);
+    } else {
+        fk_spawn_pipeline_publish(job, FK_SPAWN_FAILED, error->message);
+        g_error_free(error);
+    }
+
+    fk_spawn_job_free(job);
+}
+
+static void fk_spawn_pipeline_resume(FkSpawnJob *job) {
+    frida_device_resume(job->pipeline->device, job->pid, NULL, fk_spawn_pipeline_on_resumed, job);
+}
+
+// A failed injection still resumes the process so it is never left hanging.
+static void fk_spawn_pipeline_on_loaded(FkAgent *agent, guint pid, const GError *error, gpointer user_data) {
+    FkSpawnJob *job = (FkSpawnJob *) user_data;
+
+    if (error == NULL)
+        fk_spawn_pipeline_publish(job, FK_SPAWN_INSTRUMENTED, NULL);
+    else
+        fk_spawn_pipeline_publish(job, FK_SPAWN_FAILED, error->message);
+
+    fk_spawn_pipeline_resume(job);
+}
+
+static gboolean fk_spawn_pipeline_matches(FkSpawnPipeline *self, const gchar *identifier) {
+    if (g_hash_table_size(self->identifiers) == 0)
+        return TRUE;
+    return identifier != NULL && g_hash_table_contains(self->identifiers, identifier);
+}
+
+static void fk_spawn_pipeline_handle(FkSpawnPipeline *self, FridaSpawn *spawn) {
+    guint pid = frida_spawn_get_pid(spawn);
+
+    // A spawn gated while start_sync() runs is reported both by the signal
+    // and by the pending list.
+    if (!g_hash_table_add(self->in_flight, GUINT_TO_POINTER(pid)))
+        return;
+
+    FkSpawnJob *job = g_new0(FkSpawnJob, 1);
+    job->pipeline = fk_spawn_pipeline_ref(self);
+    job->pid = pid;
+    job->identifier = g_strdup(frida_spawn_get_identifier(spawn));
+    job->started = g_get_monotonic_time();
+
+    fk_spawn_pipeline_publish(job, FK_SPAWN_ADDED, NULL);
+
+    if (fk_spawn_pipeline_matches(self, job->identifier)) {
+        fk_agent_load(self->agent, self->device, job->pid, fk_spawn_pipeline_on_loaded, job);
+    } else {
+        fk_spawn_pipeline_publish(job, FK_SPAWN_SKIPPED, NULL);
+        fk_spawn_pipeline_resume(job);
+    }
+}
+
+static void fk_spawn_pipeline_on_spawn_added(FridaDevice *device, FridaSpawn *spawn, gpointer user_data) {
+    fk_spawn_pipeline_handle((FkSpawnPipeline *) user_data, spawn);
+}
+
+FkSpawnPipeline *fk_spawn_pipeline_new(FridaDevice *device, FkAgent *agent) {
+    FkSpawnPipeline *self = g_new0(FkSpawnPipeline, 1);
+    self->ref_count = 1;
+    self->device = (FridaDevice *) g_object_ref(device);
+    self->agent = fk_agent_ref(agent);
+    self->identifiers = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    self->in_flight = g_hash_table_new(NULL, NULL);
+    self->events = fk_event_queue_new(0);
+    return self;
+}
+
+void fk_spawn_pipeline_free(FkSpawnPipeline *self) {
+    if (self == NULL)
+        return;
+    if (self->running)
+        fk_spawn_pipeline_stop_sync(self, NULL);
+    fk_event_queue_close(self->events);
+    fk_spawn_pipeline_unref(self);
+}
+
+void fk_spawn_pipeline_add_identifier(FkSpawnPipeline *self, const gchar *identifier) {
+    g_hash_table_add(self->identifiers, g_strdup(identifier));
+}
+
+static void fk_spawn_pipeline_connect(gpointer user_data) {
+    FkSpawnPipeline *self = (FkSpawnPipeline *) user_data;
+    self->spawn_added_handler =
+        g_signal_connect(self->device, "spawn-added", G_CALLBACK(fk_spawn_pipeline_on_spawn_added), self);
+}
+
+static void fk_spawn_pipeline_disconnect(gpointer user_data) {
+    FkSpawnPipeline *self = (FkSpawnPipeline *) user_data;
+    if (self->spawn_added_handler != 0) {
+        g_signal_handler_disconnect(self->device, self->spawn_added_handler);
+        self->spawn_added_handler = 0;
+    }
+}
+
+struct FkSpawnBacklog {
+    FkSpawnPipeline *pipeline;
+    FridaSpawnList *pending;
+};
+
+static void fk_spawn_pipeline_drain_pending(gpointer user_data) {
+    FkSpawnBacklog *backlog = (FkSpawnBacklog *) user_data;
+
+    gint size = frida_spawn_list_size(backlog->pending);
+    for (gint i = 0; i != size; i++) {
+        FridaSpawn *spawn = frida_spawn_list_get(backlog->pending, i);
+        fk_spawn_pipeline_handle(backlog->pipeline, spawn);
+        g_object_unref(spawn);
+    }
+}
+
+// Spawns that were already gated before the pipeline started are handled the
+// same way as new ones, so nothing stays suspended.
+void fk_spawn_pipeline_start_sync(FkSpawnPipeline *self, GError **error) {
+    GError *gating_error = NULL;
+
+    fk_invoke_sync(fk_spawn_pipeline_connect, self);
+
+    frida_device_enable_spawn_gating_sync(self->device, NULL, &gating_error);
+    if (gating_error != NULL) {
+        fk_invoke_sync(fk_spawn_pipeline_disconnect, self);
+        g_propagate_error(error, gating_error);
+        return;
+    }
+    self->running = TRUE;
+
+    FkSpawnBacklog backlog = { self, frida_device_enumerate_pending_spawn_sync(self->device, NULL, NULL) };
+    if (backlog.pending != NULL) {
+        fk_invoke_sync(fk_spawn_pipeline_drain_pending, &backlog);
+        g_object_unref(backlog.pending);
+    }
+}
+
+void fk_spawn_pipeline_stop_sync(FkSpawnPipeline *self, GError **error) {
+    fk_invoke_sync(fk_spawn_pipeline_disconnect, self);
+    self->running = FALSE;
+    frida_device_disable_spawn_gating_sync(self->device, NULL, error);
+}
+
+FkEventQueue *fk_spawn_pipeline_get_events(FkSpawnPipeline *self) {
+    return self->events;
+}
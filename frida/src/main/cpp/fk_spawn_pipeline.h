@@ -0,0 +1,36 @@
+#ifndef __FK_SPAWN_PIPELINE_H__
+#define __FK_SPAWN_PIPELINE_H__
+
+#include "frida_core.h"
+#include "fk_agent.h"
+#include "fk_event_queue.h"
+
+G_BEGIN_DECLS
+
+// Enables spawn gating on a device and, for every gated spawn whose
+// identifier matches (or every spawn, if no identifiers were added), attaches,
+// loads the agent and resumes the process from the frida main context.
+// Non-matching spawns are resumed right away. Progress is published as:
+//   u8 FkSpawnEvent, u32 pid, string identifier, string error, i64 elapsed us
+// where elapsed is measured from spawn-added.
+typedef struct _FkSpawnPipeline FkSpawnPipeline;
+
+typedef enum {
+    FK_SPAWN_ADDED,
+    FK_SPAWN_INSTRUMENTED,
+    FK_SPAWN_RESUMED,
+    FK_SPAWN_SKIPPED,
+    FK_SPAWN_FAILED
+} FkSpawnEvent;
+
+FkSpawnPipeline *fk_spawn_pipeline_new(FridaDevice *device, FkAgent *agent);
+void fk_spawn_pipeline_free(FkSpawnPipeline *self);
+
+void fk_spawn_pipeline_add_identifier(FkSpawnPipeline *self, const gchar *identifier);
+void fk_spawn_pipeline_start_sync(FkSpawnPipeline *self, GError **error);
+void fk_spawn_pipeline_stop_sync(FkSpawnPipeline *self, GError **error);
+FkEventQueue *fk_spawn_pipeline_get_events(FkSpawnPipeline *self);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,213 @@
+#include "fk_stdio.h"
+#include "fk_main_context.h"
+#include "fk_ring.h"
+
+// Bytes dropped right after the position-th byte ever put in the ring.
+struct FkStdioGap {
+    guint64 position;
+    gint64 lost;
+};
+
+struct FkStdioStream {
+    FkRing *ring;
+    guint64 written;
+    guint64 consumed;
+    GArray *gaps;
+    gboolean eof;
+    gint64 dropped;
+};
+
+struct _FkStdioCapture {
+    FridaDevice *device;
+    GMutex lock;
+    GCond cond;
+    GHashTable *streams;
+    gsize capacity;
+    gboolean closed;
+    gulong output_handler;
+};
+
+static gpointer fk_stdio_key(guint pid, gint fd) {
+    return GSIZE_TO_POINTER(((gsize) pid << 2) | (gsize) (fd & 3));
+}
+
+static void fk_stdio_stream_free(gpointer data) {
+    FkStdioStream *stream = (FkStdioStream *) data;
+    delete stream->ring;
+    g_array_unref(stream->gaps);
+    g_free(stream);
+}
+
+static void fk_stdio_stream_drop(FkStdioStream *stream, gint64 lost) {
+    stream->dropped += lost;
+
+    // Back-to-back losses with nothing accepted in between are one gap.
+    if (stream->gaps->len != 0) {
+        FkStdioGap *last = &g_array_index(stream->gaps, FkStdioGap, stream->gaps->len - 1);
+        if (last->position == stream->written) {
+            last->lost += lost;
+            return;
+        }
+    }
+    FkStdioGap gap = { stream->written, lost };
+    g_array_append_val(stream->gaps, gap);
+}
+
+static void fk_stdio_capture_on_output(FridaDevice *device, guint pid, gint fd, GBytes *data, gpointer user_data) {
+    FkStdioCapture *self = (FkStdioCapture *) user_data;
+    gsize size;
+    const guint8 *bytes = (const guint8 *) g_bytes_get_data(data, &size);
+
+    g_mutex_lock(&self->lock);
+
+    FkStdioStream *stream = (FkStdioStream *) g_hash_table_lookup(self->streams, fk_stdio_key(pid, fd));
+    if (stream != NULL && !self->closed) {
+        // An empty chunk is how frida reports that the pipe was closed.
+        if (size == 0) {
+            stream->eof = TRUE;
+        } else {
+            gsize accepted = stream->ring->put(bytes, size);
+            stream->written += accepted;
+            if (accepted != size)
+                fk_stdio_stream_drop(stream, size - accepted);
+        }
+        g_cond_broadcast(&self->cond);
+    }
+
+    g_mutex_unlock(&self->lock);
+}
+
+static void fk_stdio_capture_connect(gpointer user_data) {
+    FkStdioCapture *self = (FkStdioCapture *) user_data;
+    self->output_handler = g_signal_connect(self->device, "output", G_CALLBACK(fk_stdio_capture_on_output), self);
+}
+
+static void fk_stdio_capture_disconnect(gpointer user_data) {
+    FkStdioCapture *self = (FkStdioCapture *) user_data;
+    g_signal_handler_disconnect(self->device, self->output_handler);
+}
+
+FkStdioCapture *fk_stdio_capture_new(FridaDevice *device, guint capacity) {
+    FkStdioCapture *self = g_new0(FkStdioCapture, 1);
+    self->device = (FridaDevice *) g_object_ref(device);
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+    self->streams = g_hash_table_new_full(NULL, NULL, NULL, fk_stdio_stream_free);
+    self->capacity = MAX(capacity, 1);
+
+    fk_invoke_sync(fk_stdio_capture_connect, self);
+
+    return self;
+}
+
+void fk_stdio_capture_free(FkStdioCapture *self) {
+    if (self == NULL)
+        return;
+
+    fk_stdio_capture_close(self);
+    fk_invoke_sync(fk_stdio_capture_disconnect, self);
+
+    g_hash_table_unref(self->streams);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+    g_object_unref(self->device);
+    g_free(self);
+}
+
+void fk_stdio_capture_close(FkStdioCapture *self) {
+    g_mutex_lock(&self->lock);
+    self->closed = TRUE;
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+}
+
+void fk_stdio_capture_watch(FkStdioCapture *self, guint pid, gint streams) {
+    g_mutex_lock(&self->lock);
+    for (gint fd = 1; fd <= 2; fd++) {
+        if ((streams & (1 << (fd - 1))) == 0 || g_hash_table_contains(self->streams, fk_stdio_key(pid, fd)))
+            continue;
+        FkStdioStream *stream = g_new0(FkStdioStream, 1);
+        stream->ring = new FkRing(self->capacity);
+        stream->gaps = g_array_new(FALSE, FALSE, sizeof(FkStdioGap));
+        g_hash_table_insert(self->streams, fk_stdio_key(pid, fd), stream);
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+void fk_stdio_capture_unwatch(FkStdioCapture *self, guint pid) {
+    g_mutex_lock(&self->lock);
+    g_hash_table_remove(self->streams, fk_stdio_key(pid, 1));
+    g_hash_table_remove(self->streams, fk_stdio_key(pid, 2));
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+}
+
+gint fk_stdio_capture_read(FkStdioCapture *self, guint pid, gint fd, gpointer buffer, gsize size, gint timeout_ms) {
+    size = MIN(size, (gsize) G_MAXINT);
+
+    g_mutex_lock(&self->lock);
+
+    gint64 deadline = g_get_monotonic_time() + (gint64) timeout_ms * G_TIME_SPAN_MILLISECOND;
+    gint result = FK_STDIO_CAPTURE_ENDED;
+    FkStdioStream *stream;
+    while ((stream = (FkStdioStream *) g_hash_table_lookup(self->streams, fk_stdio_key(pid, fd))) != NULL) {
+        // Never read across a gap, so the loss surfaces exactly where it
+        // happened.
+        gsize available = stream->ring->size();
+        if (stream->gaps->len != 0) {
+            guint64 gap = g_array_index(stream->gaps, FkStdioGap, 0).position;
+            if (gap == stream->consumed) {
+                result = FK_STDIO_CAPTURE_LOST;
+                break;
+            }
+            available = MIN(available, (gsize) (gap - stream->consumed));
+        }
+        if (available != 0) {
+            result = (gint) stream->ring->take((guint8 *) buffer, MIN(size, available));
+            stream->consumed += result;
+            g_cond_broadcast(&self->cond);
+            break;
+        }
+        if (stream->eof || self->closed)
+            break;
+
+        if (timeout_ms == 0 || (timeout_ms > 0 && !g_cond_wait_until(&self->cond, &self->lock, deadline))) {
+            result = 0;
+            break;
+        }
+        if (timeout_ms < 0)
+            g_cond_wait(&self->cond, &self->lock);
+    }
+
+    g_mutex_unlock(&self->lock);
+    return result;
+}
+
+gint64 fk_stdio_capture_skip_lost(FkStdioCapture *self, guint pid, gint fd) {
+    gint64 lost = 0;
+
+    g_mutex_lock(&self->lock);
+    FkStdioStream *stream = (FkStdioStream *) g_hash_table_lookup(self->streams, fk_stdio_key(pid, fd));
+    if (stream != NULL && stream->gaps->len != 0 &&
+        g_array_index(stream->gaps, FkStdioGap, 0).position == stream->consumed) {
+        lost = g_array_index(stream->gaps, FkStdioGap, 0).lost;
+        g_array_remove_index(stream->gaps, 0);
+    }
+    g_mutex_unlock(&self->lock);
+
+    return lost;
+}
+
+gint64 fk_stdio_capture_get_dropped(FkStdioCapture *self, guint pid, gint fd) {
+    g_mutex_lock(&self->lock);
+    FkStdioStream *stream = (FkStdioStream *) g_hash_table_lookup(self->streams, fk_stdio_key(pid, fd));
+    gint64 dropped = stream != NULL ? stream->dropped : 0;
+    g_mutex_unlock(&self->lock);
+    return dropped;
+}
+
+void fk_stdio_capture_input(FkStdioCapture *self, guint pid, gconstpointer buffer, gsize size, GError **error) {
+    GBytes *data = g_bytes_new(buffer, size);
+    frida_device_input_sync(self->device, pid, data, NULL, error);
+    g_bytes_unref(data);
+}
@@ -0,0 +1,52 @@
+#ifndef __FK_STDIO_H__
+#define __FK_STDIO_H__
+
+#include "frida_core.h"
+
+G_BEGIN_DECLS
+
+// Captures the device's output signal into one bounded ring buffer per watched
+// (pid, fd), so processes spawned with FRIDA_STDIO_PIPE can be streamed from
+// Kotlin without an upcall per chunk. The output signal has no way to push
+// back on the process, so there is no upstream backpressure: the handler runs
+// on the shared frida main context and never waits, and whatever does not fit
+// in a full ring is dropped. Each loss is recorded at its position in the
+// stream and reported to the reader in-band, once it has read up to it. Output
+// for streams that are not watched is discarded, so watch the ones that will
+// be read before resuming.
+typedef struct _FkStdioCapture FkStdioCapture;
+
+typedef enum {
+    FK_STDIO_CAPTURE_STDOUT = 1 << 0,
+    FK_STDIO_CAPTURE_STDERR = 1 << 1
+} FkStdioCaptureStreams;
+
+typedef enum {
+    FK_STDIO_CAPTURE_ENDED = -1,
+    FK_STDIO_CAPTURE_LOST = -2
+} FkStdioCaptureStatus;
+
+FkStdioCapture *fk_stdio_capture_new(FridaDevice *device, guint capacity);
+void fk_stdio_capture_free(FkStdioCapture *self);
+// Stops capturing and wakes blocked readers, which drain what is left.
+void fk_stdio_capture_close(FkStdioCapture *self);
+
+void fk_stdio_capture_watch(FkStdioCapture *self, guint pid, gint streams);
+void fk_stdio_capture_unwatch(FkStdioCapture *self, guint pid);
+
+// Copies up to size pending bytes into buffer, waiting up to timeout_ms
+// (forever when negative). Returns the number of bytes copied, 0 on timeout,
+// FK_STDIO_CAPTURE_LOST when the next bytes were dropped (see skip_lost), or
+// FK_STDIO_CAPTURE_ENDED once the stream has ended and is drained, or is not
+// watched.
+gint fk_stdio_capture_read(FkStdioCapture *self, guint pid, gint fd, gpointer buffer, gsize size, gint timeout_ms);
+// Acknowledges the loss read() stopped at and returns how many bytes it
+// spans; reading then resumes with what arrived after it.
+gint64 fk_stdio_capture_skip_lost(FkStdioCapture *self, guint pid, gint fd);
+gint64 fk_stdio_capture_get_dropped(FkStdioCapture *self, guint pid, gint fd);
+
+void fk_stdio_capture_input(FkStdioCapture *self, guint pid, gconstpointer buffer, gsize size, GError **error);
+
+G_END_DECLS
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef __FK_WRITER_H__
+#define __FK_WRITER_H__
+
+#include "frida_core.h"
+
+// Little-endian record encoder shared by every native helper that hands data
+// to Kotlin. The matching decoder is dev.supersam.frida.NativeReader.
+class FkWriter {
+public:
+    FkWriter() : bytes(g_byte_array_new()) {}
+
+    ~FkWriter() {
+        if (bytes != NULL)
+            g_byte_array_unref(bytes);
+    }
+
+    void put_u8(guint8 value) {
+        g_byte_array_append(bytes, &value, 1);
+    }
+
+    void put_bool(gboolean value) {
+        put_u8(value ? 1 : 0);
+    }
+
+    void put_u32(guint32 value) {
+        guint32 le = GUINT32_TO_LE(value);
+        g_byte_array_append(bytes, (const guint8 *) &le, sizeof(le));
+    }
+
+    void put_i64(gint64 value) {
+        guint64 le = GUINT64_TO_LE((guint64) value);
+        g_byte_array_append(bytes, (const guint8 *) &le, sizeof(le));
+    }
+
+    void put_double(gdouble value) {
+        guint64 raw;
+        memcpy(&raw, &value, sizeof(raw));
+        put_i64((gint64) raw);
+    }
+
+    // Strings and blobs are length-prefixed; G_MAXUINT32 marks NULL.
+    void put_string(const gchar *value) {
+        if (value == NULL) {
+            put_u32(G_MAXUINT32);
+            return;
+        }
+        gsize length = strlen(value);
+        put_u32((guint32) length);
+        g_byte_array_append(bytes, (const guint8 *) value, (guint) length);
+    }
+
+    void put_bytes(gconstpointer data, gsize size) {
+        if (data == NULL && size == 0) {
+            put_u32(G_MAXUINT32);
+            return;
+        }
+        put_u32((guint32) size);
+        g_byte_array_append(bytes, (const guint8 *) data, (guint) size);
+    }
+
+    void put_gbytes(GBytes *value) {
+        if (value == NULL) {
+            put_u32(G_MAXUINT32);
+            return;
+        }
+        gsize size;
+        gconstpointer data = g_bytes_get_data(value, &size);
+        put_u32((guint32) size);
+        g_byte_array_append(bytes, (const guint8 *) data, (guint) size);
+    }
+
+    void patch_u32(gsize offset, guint32 value) {
+        guint32 le = GUINT32_TO_LE(value);
+        memcpy(bytes->data + offset, &le, sizeof(le));
+    }
+
+    const guint8 *data() const {
+        return bytes->data;
+    }
+
+    gsize size() const {
+        return bytes->len;
+    }
+
+    void reset() {
+        g_byte_array_set_size(bytes, 0);
+    }
+
+    GBytes *steal() {
+        GBytes *result = g_byte_array_free_to_bytes(bytes);
+        bytes = g_byte_array_new();
+        return result;
+    }
+
+private:
+    GByteArray *bytes;
+
+    FkWriter(const FkWriter &);
+    FkWriter &operator=(const FkWriter &);
+};
+
+#endif
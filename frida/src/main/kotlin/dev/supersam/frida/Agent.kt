@@ -0,0 +1,114 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+
+class Agent private constructor(
+    source: String?,
+    bytes: ByteArray?,
+    name: String?,
+    queueCapacity: Int
+) : AutoCloseable {
+    constructor(source: String, name: String? = null, queueCapacity: Int = DEFAULT_QUEUE_CAPACITY) :
+            this(source, null, name, queueCapacity)
+
+    init {
+        Frida.ensureInitialized()
+    }
+
+    private val closed = AtomicBoolean()
+    internal val handle = frida.fk_agent_new(name, source, bytes, queueCapacity.toLong())
+    private val events = EventQueue(frida.fk_agent_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(List<Event>) -> Unit>()
+    private val pump = events.pump("frida-agent") { batch ->
+        val decoded = batch.records.map { it.event() }
+        listeners.forEach { it(decoded) }
+    }
+
+    sealed class Event {
+        abstract val pid: Long
+
+        class Message(override val pid: Long, val json: String, val data: ByteArray?) : Event()
+        data class Loaded(override val pid: Long, val transport: PeerOptions.Transport) : Event()
+        data class Detached(override val pid: Long, val reason: Int) : Event()
+        data class Reloaded(override val pid: Long) : Event()
+        data class ReloadFailed(override val pid: Long, val error: String) : Event()
+    }
+
+    val pids: List<Long>
+        get() = transports.keys.toList()
+
+    // The transport each live instance's script traffic goes over.
+    val transports: Map<Long, PeerOptions.Transport>
+        get() {
+            val reader = NativeReader(frida.fk_agent_enumerate_pids(handle))
+            val count = reader.u32().toInt()
+            val result = LinkedHashMap<Long, PeerOptions.Transport>(count)
+            repeat(count) { result[reader.u32()] = reader.transport() }
+            return result
+        }
+
+    fun addListener(listener: (List<Event>) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (List<Event>) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun inject(device: Frida.Device, pid: Long) {
+        Frida.devices.withDevice(device.id) { frida.fk_agent_inject_sync(handle, it, pid) }
+    }
+
+    // Sessions attached after this call set up a peer connection first and
+    // fall back to the control channel if that fails; null turns it off.
+    fun usePeerConnections(options: PeerOptions?) {
+        if (options == null) frida.fk_agent_set_peer_options(handle, null)
+        else options.withNative { frida.fk_agent_set_peer_options(handle, it) }
+    }
+
+    fun post(json: String, data: ByteArray? = null, pid: Long = ALL_PROCESSES) {
+        frida.fk_agent_post(handle, pid, json, data)
+    }
+
+    // Swaps the script in every live session for one built from source; see
+    // HotReload for doing this on every rebuild.
+    fun reload(source: String) {
+        frida.fk_agent_reload(handle, source)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_agent_free(handle)
+    }
+
+    companion object {
+        const val ALL_PROCESSES = 0L
+        const val DEFAULT_QUEUE_CAPACITY = 16 * 1024 * 1024
+
+        private const val MESSAGE = 0
+        private const val LOADED = 1
+        private const val DETACHED = 2
+        private const val RELOADED = 3
+
+        fun fromBytes(bytes: ByteArray, name: String? = null, queueCapacity: Int = DEFAULT_QUEUE_CAPACITY) =
+            Agent(null, bytes, name, queueCapacity)
+
+        private fun NativeReader.transport() = PeerOptions.Transport.values()[u8()]
+
+        private fun NativeReader.event(): Event {
+            val kind = u8()
+            val pid = u32()
+            return when (kind) {
+                MESSAGE -> Event.Message(pid, string()!!, bytes())
+                LOADED -> Event.Loaded(pid, transport())
+                DETACHED -> Event.Detached(pid, u32().toInt())
+                RELOADED -> Event.Reloaded(pid)
+                else -> Event.ReloadFailed(pid, string()!!)
+            }
+        }
+    }
+}
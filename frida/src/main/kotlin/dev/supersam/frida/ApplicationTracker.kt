@@ -0,0 +1,46 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.atomic.AtomicBoolean
+
+class ApplicationTracker(device: Frida.Device, keys: Set<String>? = null) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = Frida.devices.withDevice(device.id) {
+        frida.fk_app_tracker_new(it, keys?.joinToString(","))
+    }
+
+    sealed class Change {
+        abstract val application: Frida.Application
+
+        data class Added(override val application: Frida.Application) : Change()
+        data class Removed(override val application: Frida.Application) : Change()
+        data class Changed(override val application: Frida.Application) : Change()
+    }
+
+    fun poll(): List<Change> {
+        val reader = NativeReader(frida.fk_app_tracker_poll(handle))
+        return List(reader.u32().toInt()) {
+            val kind = reader.u8()
+            val application = Frida.Application(
+                identifier = reader.string()!!,
+                name = reader.string()!!,
+                pid = reader.u32(),
+                parameters = reader.variantDict()
+            )
+            when (kind) {
+                0 -> Change.Added(application)
+                1 -> Change.Removed(application)
+                else -> Change.Changed(application)
+            }
+        }
+    }
+
+    fun reset() {
+        frida.fk_app_tracker_reset(handle)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        frida.fk_app_tracker_free(handle)
+    }
+}
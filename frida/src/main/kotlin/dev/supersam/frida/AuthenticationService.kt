@@ -0,0 +1,77 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
+
+// Authenticates tokens presented to hosted control and portal services.
+// authenticate runs on a pool of `concurrency` threads, never on the frida
+// main context, so a slow backend only delays the handshakes waiting on it.
+// It returns the session info JSON for an accepted token, or null to reject.
+// Accepted tokens are cached natively (cacheCapacity entries, for cacheTtlMs;
+// 0 keeps them until evicted) and are not asked about again.
+class AuthenticationService(
+    cacheCapacity: Int = DEFAULT_CACHE_CAPACITY,
+    cacheTtlMs: Int = DEFAULT_CACHE_TTL_MS,
+    concurrency: Int = DEFAULT_CONCURRENCY,
+    private val authenticate: (token: String) -> String?
+) : AutoCloseable {
+    init {
+        Frida.ensureInitialized()
+    }
+
+    internal val handle = frida.fk_auth_service_new(cacheCapacity.toLong(), cacheTtlMs.toLong())
+    private val lifecycle = ReentrantReadWriteLock()
+    private var freed = false
+    private val workers: ExecutorService = Executors.newFixedThreadPool(concurrency) { task ->
+        Thread(task, "frida-auth").apply { isDaemon = true }
+    }
+    private val requests = EventQueue(frida.fk_auth_service_get_requests(handle))
+    private val pump = requests.pump("frida-auth-requests") { batch ->
+        for (record in batch.records) {
+            val id = record.u32()
+            val token = record.string()!!
+            workers.execute { complete(id, token) }
+        }
+    }
+
+    // Drops every cached token, e.g. after revoking one.
+    fun forgetAll() = lifecycle.read {
+        if (!freed) frida.fk_auth_service_forget_all(handle)
+    }
+
+    private fun complete(id: Long, token: String) {
+        val sessionInfo = try {
+            authenticate(token)
+        } catch (e: Exception) {
+            null
+        }
+        lifecycle.read {
+            if (!freed) frida.fk_auth_service_complete(handle, id, sessionInfo)
+        }
+    }
+
+    override fun close() {
+        requests.close()
+        pump.join()
+        workers.shutdownNow()
+        lifecycle.write {
+            if (!freed) {
+                freed = true
+                frida.fk_auth_service_free(handle)
+            }
+        }
+    }
+
+    companion object {
+        const val DEFAULT_CACHE_CAPACITY = 1024
+        const val DEFAULT_CACHE_TTL_MS = 5 * 60 * 1000
+        const val DEFAULT_CONCURRENCY = 4
+
+        // Session info frida's own static token check hands out.
+        const val EMPTY_SESSION_INFO = "{}"
+    }
+}
@@ -0,0 +1,69 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicLong
+
+class Bus(
+    device: Frida.Device,
+    queueCapacity: Int = DEFAULT_QUEUE_CAPACITY,
+    coalesceMs: Int = 0
+) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = Frida.devices.withDevice(device.id) {
+        frida.fk_bus_new(it, queueCapacity.toLong(), coalesceMs.toLong())
+    }
+    private val events = EventQueue(frida.fk_bus_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(List<Event>) -> Unit>()
+    private val dropped = AtomicLong()
+    private val pump = events.pump("frida-bus") { batch ->
+        dropped.addAndGet(batch.dropped)
+        val decoded = batch.records.map { it.event() }
+        listeners.forEach { it(decoded) }
+    }
+
+    sealed class Event {
+        class Message(val json: String, val data: ByteArray?) : Event()
+        object Detached : Event()
+    }
+
+    val isDetached: Boolean
+        get() = frida.fk_bus_is_detached(handle)
+
+    val droppedEvents: Long
+        get() = dropped.get()
+
+    fun addListener(listener: (List<Event>) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (List<Event>) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun attach(): Bus {
+        frida.fk_bus_attach_sync(handle)
+        return this
+    }
+
+    fun post(json: String, data: ByteArray? = null) {
+        frida.fk_bus_post(handle, json, data)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_bus_free(handle)
+    }
+
+    companion object {
+        const val DEFAULT_QUEUE_CAPACITY = 16 * 1024 * 1024
+
+        private fun NativeReader.event(): Event = when (u8()) {
+            0 -> Event.Message(string()!!, bytes())
+            else -> Event.Detached
+        }
+    }
+}
@@ -0,0 +1,67 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+
+class ChildFollower(device: Frida.Device, agent: Agent) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = Frida.devices.withDevice(device.id) { frida.fk_child_follower_new(it, agent.handle) }
+    private val events = EventQueue(frida.fk_child_follower_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(Event) -> Unit>()
+    private val pump = events.pump("frida-child-follower") { batch ->
+        batch.records.forEach { record ->
+            val event = record.event()
+            listeners.forEach { it(event) }
+        }
+    }
+
+    sealed class Event {
+        abstract val child: Frida.Child
+        abstract val elapsedMicros: Long
+
+        data class Added(override val child: Frida.Child, override val elapsedMicros: Long) : Event()
+        data class Instrumented(override val child: Frida.Child, override val elapsedMicros: Long) : Event()
+        data class Resumed(override val child: Frida.Child, override val elapsedMicros: Long) : Event()
+        data class Failed(override val child: Frida.Child, override val elapsedMicros: Long, val message: String) : Event()
+    }
+
+    fun addListener(listener: (Event) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (Event) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun start(): ChildFollower {
+        frida.fk_child_follower_start_sync(handle)
+        return this
+    }
+
+    fun stop() {
+        frida.fk_child_follower_stop_sync(handle)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_child_follower_free(handle)
+    }
+
+    private companion object {
+        fun NativeReader.event(): Event {
+            val kind = u8()
+            val child = child()
+            val error = string()
+            val elapsed = i64()
+            return when (kind) {
+                0 -> Event.Added(child, elapsed)
+                1 -> Event.Instrumented(child, elapsed)
+                2 -> Event.Resumed(child, elapsed)
+                else -> Event.Failed(child, elapsed, error ?: "")
+            }
+        }
+    }
+}
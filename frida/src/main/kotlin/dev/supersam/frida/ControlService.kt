@@ -0,0 +1,71 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.atomic.AtomicBoolean
+
+class ControlService(
+    val address: String = "127.0.0.1",
+    val port: Int = DEFAULT_PORT,
+    private val certificate: String? = null,
+    origin: String? = null,
+    private val token: String? = null,
+    options: Options = Options(),
+    authentication: AuthenticationService? = null,
+    assetRoot: String? = null
+) : AutoCloseable {
+    init {
+        Frida.ensureInitialized()
+    }
+
+    private val endpoint =
+        frida.fk_endpoint_parameters_new(address, port, certificate, origin, token, authentication?.handle, assetRoot)
+    private val serviceOptions = frida.frida_control_service_options_new().also {
+        options.sysroot?.let { sysroot -> frida.frida_control_service_options_set_sysroot(it, sysroot) }
+        frida.frida_control_service_options_set_enable_preload(it, options.enablePreload)
+        frida.frida_control_service_options_set_report_crashes(it, options.reportCrashes)
+    }
+    private val closed = AtomicBoolean()
+    private val handle = frida.frida_control_service_new(endpoint, serviceOptions)
+    private var started = false
+
+    data class Options(
+        val sysroot: String? = null,
+        val enablePreload: Boolean = true,
+        val reportCrashes: Boolean = true
+    )
+
+    val listenAddress: String
+        get() = "$address:$port"
+
+    @Synchronized
+    fun start(): ControlService {
+        if (!started) {
+            frida.frida_control_service_start_sync(handle)
+            started = true
+        }
+        return this
+    }
+
+    @Synchronized
+    fun stop() {
+        if (started) {
+            frida.frida_control_service_stop_sync(handle)
+            started = false
+        }
+    }
+
+    fun connect(pool: RemoteDevicePool = Frida.remoteDevices): Frida.Device =
+        pool.add(listenAddress, RemoteDevicePool.Options(certificate = certificate, token = token))
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        stop()
+        frida.fk_control_service_unref(handle)
+        frida.fk_control_service_options_unref(serviceOptions)
+        frida.fk_endpoint_parameters_unref(endpoint)
+    }
+
+    companion object {
+        const val DEFAULT_PORT = 27042
+    }
+}
@@ -0,0 +1,83 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicLong
+
+class CrashCollector(queueCapacity: Int = DEFAULT_QUEUE_CAPACITY) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = frida.fk_crash_collector_new(Frida.devices.handle, queueCapacity.toLong())
+    private val events = EventQueue(frida.fk_crash_collector_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(List<Event>) -> Unit>()
+    private val dropped = AtomicLong()
+    private val pump = events.pump("frida-crash-collector") { batch ->
+        dropped.addAndGet(batch.dropped)
+        val decoded = batch.records.map { it.event() }
+        listeners.forEach { it(decoded) }
+    }
+
+    sealed class Event {
+        abstract val crashId: Long
+        abstract val deviceId: String
+        abstract val pid: Long
+
+        data class New(
+            override val crashId: Long,
+            override val deviceId: String,
+            override val pid: Long,
+            val processName: String?,
+            val summary: String
+        ) : Event()
+
+        data class Repeated(
+            override val crashId: Long,
+            override val deviceId: String,
+            override val pid: Long,
+            val count: Long
+        ) : Event()
+    }
+
+    val droppedEvents: Long
+        get() = dropped.get()
+
+    fun addListener(listener: (List<Event>) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (List<Event>) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun report(crashId: Long): String? =
+        frida.fk_crash_collector_get_report(handle, crashId)?.toString(Charsets.UTF_8)
+
+    fun parameters(crashId: Long): Map<String, Any?>? =
+        frida.fk_crash_collector_get_parameters(handle, crashId)?.let { NativeReader(it).variantDict() }
+
+    fun forget(crashId: Long) {
+        frida.fk_crash_collector_forget(handle, crashId)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_crash_collector_free(handle)
+    }
+
+    companion object {
+        const val DEFAULT_QUEUE_CAPACITY = 1024 * 1024
+
+        private fun NativeReader.event(): Event {
+            val kind = u8()
+            val id = u32()
+            val deviceId = string()!!
+            val pid = u32()
+            return when (kind) {
+                0 -> Event.New(id, deviceId, pid, string(), string() ?: "")
+                else -> Event.Repeated(id, deviceId, pid, u32())
+            }
+        }
+    }
+}
@@ -0,0 +1,104 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FkChannelReadiness
+import dev.supersam.fridaSource.SWIGTYPE_p__FkChannel
+import dev.supersam.fridaSource.frida
+import java.io.IOException
+import java.nio.ByteBuffer
+import java.nio.channels.AsynchronousCloseException
+import java.nio.channels.ByteChannel
+import java.nio.channels.ClosedChannelException
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
+
+// In blocking mode reads and writes go straight between the stream and the
+// caller's direct buffer. In non-blocking mode they return 0 instead of
+// waiting; use awaitReadable/awaitWritable to wait for readiness.
+class DeviceChannel private constructor(
+    private val handle: SWIGTYPE_p__FkChannel,
+    val isBlocking: Boolean
+) : ByteChannel {
+    private val lifecycle = ReentrantReadWriteLock()
+
+    private val closed = AtomicBoolean()
+    private var readScratch: ByteBuffer? = null
+    private var writeScratch: ByteBuffer? = null
+
+    override fun read(dst: ByteBuffer): Int {
+        if (!dst.hasRemaining()) return 0
+        if (dst.isDirect) {
+            val n = native { frida.fk_channel_read(handle, dst.slice()) }
+            if (n > 0) dst.position(dst.position() + n)
+            return n
+        }
+
+        val scratch = scratch(readScratch, dst.remaining()).also { readScratch = it }
+        val n = native { frida.fk_channel_read(handle, scratch.slice()) }
+        if (n > 0) dst.put(scratch.limit(n) as ByteBuffer)
+        return n
+    }
+
+    override fun write(src: ByteBuffer): Int {
+        if (!src.hasRemaining()) return 0
+        val data = if (src.isDirect) src.slice() else {
+            val scratch = scratch(writeScratch, src.remaining()).also { writeScratch = it }
+            scratch.put(src.duplicate().limit(src.position() + scratch.remaining()) as ByteBuffer).flip()
+            scratch.slice()
+        }
+        val n = native { frida.fk_channel_write(handle, data) }
+        if (n > 0) src.position(src.position() + n)
+        return n
+    }
+
+    fun awaitReadable(timeoutMs: Int = -1): Boolean = await(FkChannelReadiness.FK_CHANNEL_READABLE, timeoutMs)
+
+    fun awaitWritable(timeoutMs: Int = -1): Boolean = await(FkChannelReadiness.FK_CHANNEL_WRITABLE, timeoutMs)
+
+    override fun isOpen() = !closed.get()
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        // Closed under the read lock so blocked calls wake up and see it;
+        // the write lock then waits for them to leave before unref.
+        lifecycle.read { frida.fk_channel_close(handle) }
+        lifecycle.write { frida.fk_channel_unref(handle) }
+    }
+
+    private fun await(interest: FkChannelReadiness, timeoutMs: Int): Boolean =
+        native { frida.fk_channel_poll(handle, interest.swigValue(), timeoutMs) } != 0
+
+    private fun <T> native(block: () -> T): T = lifecycle.read {
+        if (closed.get()) throw ClosedChannelException()
+        try {
+            block()
+        } catch (e: RuntimeException) {
+            if (closed.get()) throw AsynchronousCloseException()
+            throw IOException(e.message, e)
+        }
+    }
+
+    companion object {
+        const val DEFAULT_BUFFER_CAPACITY = 256 * 1024
+        private const val SCRATCH_SIZE = 64 * 1024
+
+        fun open(
+            device: Frida.Device,
+            address: String,
+            blocking: Boolean = true,
+            bufferCapacity: Int = DEFAULT_BUFFER_CAPACITY
+        ): DeviceChannel {
+            val handle = Frida.devices.withDevice(device.id) {
+                frida.fk_channel_open_sync(it, address, !blocking, bufferCapacity.toLong())
+            }
+            return DeviceChannel(handle, blocking)
+        }
+
+        private fun scratch(current: ByteBuffer?, size: Int): ByteBuffer {
+            val buffer = current ?: ByteBuffer.allocateDirect(SCRATCH_SIZE)
+            buffer.clear().limit(minOf(size, buffer.capacity()))
+            return buffer
+        }
+    }
+}
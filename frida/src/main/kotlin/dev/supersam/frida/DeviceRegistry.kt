@@ -0,0 +1,103 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FridaDeviceType
+import dev.supersam.fridaSource.SWIGTYPE_p__FridaDevice
+import dev.supersam.fridaSource.SWIGTYPE_p__FridaDeviceManager
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+
+class DeviceRegistry internal constructor(manager: SWIGTYPE_p__FridaDeviceManager) {
+    internal val handle = frida.fk_device_registry_new(manager)
+    private val changes = EventQueue(frida.fk_device_registry_get_changes(handle))
+    private val known = LinkedHashMap<String, Frida.Device>()
+    private val listeners = CopyOnWriteArrayList<(Change) -> Unit>()
+
+    @Volatile
+    private var snapshot: List<Frida.Device>
+
+    @Volatile
+    private var byId: Map<String, Frida.Device>
+
+    init {
+        val reader = NativeReader(frida.fk_device_registry_snapshot(handle))
+        repeat(reader.u32().toInt()) {
+            val device = reader.device()
+            known[device.id] = device
+        }
+        snapshot = known.values.toList()
+        byId = known.toMap()
+    }
+
+    val devices: List<Frida.Device>
+        get() {
+            refresh()
+            return snapshot
+        }
+
+    operator fun get(id: String): Frida.Device? {
+        refresh()
+        return byId[id]
+    }
+
+    fun addListener(listener: (Change) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (Change) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    @Synchronized
+    fun refresh(timeoutMs: Int = 0): List<Change> {
+        val batch = changes.drain(timeoutMs) ?: return emptyList()
+        val applied = batch.records.map { record ->
+            val kind = record.u8()
+            val device = record.device()
+            if (kind == ADDED) {
+                known[device.id] = device
+                Change.Added(device)
+            } else {
+                known.remove(device.id)
+                Change.Removed(device)
+            }
+        }
+        snapshot = known.values.toList()
+        byId = known.toMap()
+        applied.forEach { change -> listeners.forEach { it(change) } }
+        return applied
+    }
+
+    fun systemParameters(id: String): Map<String, Any?> =
+        NativeReader(frida.fk_device_registry_query_system_parameters(handle, id)).variantDict()
+
+    fun invalidateSystemParameters() {
+        frida.fk_device_registry_invalidate(handle)
+    }
+
+    internal fun <T> withDevice(id: String, block: (SWIGTYPE_p__FridaDevice) -> T): T {
+        val device = frida.fk_device_registry_lookup(handle, id)
+            ?: throw IllegalArgumentException("No such device: $id")
+        try {
+            return block(device)
+        } finally {
+            frida.fk_device_unref(device)
+        }
+    }
+
+    sealed class Change {
+        abstract val device: Frida.Device
+
+        data class Added(override val device: Frida.Device) : Change()
+        data class Removed(override val device: Frida.Device) : Change()
+    }
+
+    private companion object {
+        const val ADDED = 0
+
+        fun NativeReader.device() = Frida.Device(
+            id = string()!!,
+            name = string()!!,
+            type = FridaDeviceType.swigToEnum(u32().toInt())
+        )
+    }
+}
@@ -0,0 +1,18 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.SWIGTYPE_p__FridaEndpointParameters
+import dev.supersam.fridaSource.frida
+
+data class Endpoint(
+    val address: String = "127.0.0.1",
+    val port: Int,
+    val certificate: String? = null,
+    val origin: String? = null,
+    val token: String? = null,
+    val authentication: AuthenticationService? = null,
+    // Directory frida-core serves over HTTP on this endpoint, e.g. compiled agent bundles.
+    val assetRoot: String? = null
+) {
+    internal fun create(): SWIGTYPE_p__FridaEndpointParameters =
+        frida.fk_endpoint_parameters_new(address, port, certificate, origin, token, authentication?.handle, assetRoot)
+}
@@ -0,0 +1,23 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.SWIGTYPE_p__FkEventQueue
+import dev.supersam.fridaSource.frida
+import kotlin.concurrent.thread
+
+internal class EventQueue(private val queue: SWIGTYPE_p__FkEventQueue) {
+
+    fun drain(timeoutMs: Int = 0): NativeReader.Batch? =
+        frida.fk_event_queue_drain(queue, timeoutMs)?.let(NativeReader::batch)
+
+    fun pump(name: String, onBatch: (NativeReader.Batch) -> Unit): Thread =
+        thread(name = name, isDaemon = true) {
+            while (true) {
+                val batch = drain(-1) ?: break
+                onBatch(batch)
+            }
+        }
+
+    fun close() {
+        frida.fk_event_queue_close(queue)
+    }
+}
@@ -0,0 +1,57 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FkFanOutQuery
+import dev.supersam.fridaSource.FridaScope
+import dev.supersam.fridaSource.frida
+
+object FanOut {
+    const val DEFAULT_TIMEOUT_MS = 10_000
+
+    private const val OK = 0
+    private const val TIMED_OUT = 2
+
+    object Query {
+        fun enumerateApplications(scope: FridaScope = FridaScope.FRIDA_SCOPE_MINIMAL) =
+            Request(FkFanOutQuery.FK_FANOUT_ENUMERATE_APPLICATIONS, scope) { it.applications() }
+
+        fun enumerateProcesses(scope: FridaScope = FridaScope.FRIDA_SCOPE_MINIMAL) =
+            Request(FkFanOutQuery.FK_FANOUT_ENUMERATE_PROCESSES, scope) { it.processes() }
+    }
+
+    class Request<T> internal constructor(
+        internal val query: FkFanOutQuery,
+        internal val scope: FridaScope,
+        internal val decode: (NativeReader) -> T
+    )
+
+    data class Failure(
+        val message: String,
+        val timedOut: Boolean
+    )
+
+    data class Result<T>(
+        val results: Map<String, T>,
+        val failures: Map<String, Failure>
+    ) {
+        val isComplete: Boolean
+            get() = failures.isEmpty()
+    }
+
+    internal fun <T> run(registry: DeviceRegistry, timeoutMs: Int, request: Request<T>): Result<T> {
+        val reader = NativeReader(frida.fk_fanout_run(registry.handle, request.query, request.scope, timeoutMs))
+        val results = LinkedHashMap<String, T>()
+        val failures = LinkedHashMap<String, Failure>()
+
+        repeat(reader.u32().toInt()) {
+            val id = reader.string()!!
+            val status = reader.u8()
+            if (status == OK) {
+                results[id] = request.decode(NativeReader(reader.slice()!!))
+            } else {
+                failures[id] = Failure(reader.string() ?: "", timedOut = status == TIMED_OUT)
+            }
+        }
+
+        return Result(results, failures)
+    }
+}
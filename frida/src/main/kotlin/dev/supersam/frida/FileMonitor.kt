@@ -0,0 +1,80 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicLong
+
+// Watches a path on the local host. Changes are coalesced natively by path
+// within coalesceMs of the first one, so a build touching the same files many
+// times yields one Change per file and one listener call per window.
+class FileMonitor(
+    val path: String,
+    coalesceMs: Int = DEFAULT_COALESCE_MS,
+    queueCapacity: Int = DEFAULT_QUEUE_CAPACITY
+) : AutoCloseable {
+    init {
+        Frida.ensureInitialized()
+    }
+
+    private val closed = AtomicBoolean()
+    private val handle = frida.fk_file_monitor_new(path, coalesceMs.toLong(), queueCapacity.toLong())
+    private val events = EventQueue(frida.fk_file_monitor_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(List<Change>) -> Unit>()
+    private val dropped = AtomicLong()
+    private val pump = events.pump("frida-file-monitor") { batch ->
+        dropped.addAndGet(batch.dropped)
+        for (record in batch.records) {
+            val changes = List(record.u32().toInt()) { record.change() }
+            listeners.forEach { it(changes) }
+        }
+    }
+
+    enum class Kind {
+        CHANGED, CHANGES_DONE_HINT, DELETED, CREATED, ATTRIBUTE_CHANGED,
+        PRE_UNMOUNT, UNMOUNTED, MOVED, RENAMED, MOVED_IN, MOVED_OUT
+    }
+
+    // kind is the latest event seen for path; merged counts the raw events.
+    data class Change(val kind: Kind, val path: String, val otherPath: String?, val merged: Int)
+
+    // Windows dropped because the queue was full.
+    val droppedBatches: Long
+        get() = dropped.get()
+
+    fun addListener(listener: (List<Change>) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (List<Change>) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun enable(): FileMonitor {
+        frida.fk_file_monitor_enable_sync(handle)
+        return this
+    }
+
+    fun disable() {
+        frida.fk_file_monitor_disable_sync(handle)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_file_monitor_free(handle)
+    }
+
+    companion object {
+        const val DEFAULT_COALESCE_MS = 100
+        const val DEFAULT_QUEUE_CAPACITY = 4 * 1024 * 1024
+
+        private fun NativeReader.change() = Change(
+            kind = Kind.values().getOrElse(u8()) { Kind.CHANGED },
+            path = string()!!,
+            otherPath = string(),
+            merged = u32().toInt()
+        )
+    }
+}
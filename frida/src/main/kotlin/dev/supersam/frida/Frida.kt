@@ -1,63 +1,131 @@
 package dev.supersam.frida
 
+import dev.supersam.fridaSource.FridaChildOrigin
 import dev.supersam.fridaSource.FridaDeviceType
 import dev.supersam.fridaSource.FridaScope
-import dev.supersam.fridaSource.SWIGTYPE_p__FridaApplicationQueryOptions
 import dev.supersam.fridaSource.frida
 
 class Frida {
     companion object {
+        const val DEFAULT_PROCESS_CACHE_AGE_MS = 2000
+
         init {
             NativeLoader.load()
             frida.frida_init()
         }
 
+        internal fun ensureInitialized() {
+            // Touching the companion runs its init block.
+        }
+
         private val manager by lazy {
             frida.frida_device_manager_new()
         }
 
-        fun enumerateApplications(appId: String): List<Application> {
-            val appsIdentifiers = mutableListOf<Application>()
+        val devices by lazy {
+            DeviceRegistry(manager)
+        }
 
-            val device = frida.frida_device_manager_get_device_by_id_sync(manager, appId, 0)
+        val remoteDevices by lazy {
+            RemoteDevicePool(manager)
+        }
 
-            val option = frida.frida_application_query_options_new()
-            frida.frida_application_query_options_set_scope(option, FridaScope.FRIDA_SCOPE_FULL)
-            val apps = frida.frida_device_enumerate_applications_sync(device, option)
-            val appsSize = frida.frida_application_list_size(apps)
-            for (i in 0 until appsSize) {
-                val app = frida.frida_application_list_get(apps, i)
+        fun enumerateApplications(
+            deviceId: String,
+            scope: FridaScope = FridaScope.FRIDA_SCOPE_FULL,
+            keys: Set<String>? = null
+        ): List<Application> = devices.withDevice(deviceId) { device ->
+            val reader = NativeReader(frida.fk_device_enumerate_applications(device, scope, keys?.joinToString(",")))
+            reader.applications(withParameters = true)
+        }
 
-                appsIdentifiers.add(
-                    Application(
-                        name = frida.frida_application_get_name(app),
-                        identifier = frida.frida_application_get_identifier(app),
-                        pid = frida.frida_application_get_pid(app)
-                    )
-                )
+        fun enumerateProcesses(
+            deviceId: String,
+            scope: FridaScope = FridaScope.FRIDA_SCOPE_MINIMAL,
+            keys: Set<String>? = null
+        ): List<Process> = devices.withDevice(deviceId) { device ->
+            val reader = NativeReader(frida.fk_device_enumerate_processes(device, scope, keys?.joinToString(",")))
+            reader.processes(withParameters = true)
+        }
+
+        // Lookups consult the device's last process enumeration if it is at
+        // most maxCacheAgeMs old. timeoutMs 0 looks once; otherwise the call
+        // waits for the process to show up, -1 meaning indefinitely.
+        fun findProcess(
+            deviceId: String,
+            name: String,
+            timeoutMs: Int = 0,
+            maxCacheAgeMs: Int = DEFAULT_PROCESS_CACHE_AGE_MS
+        ): Process? = findProcess(deviceId, name, 0, timeoutMs, maxCacheAgeMs)
+
+        fun findProcess(
+            deviceId: String,
+            pid: Long,
+            timeoutMs: Int = 0,
+            maxCacheAgeMs: Int = DEFAULT_PROCESS_CACHE_AGE_MS
+        ): Process? = findProcess(deviceId, null, pid, timeoutMs, maxCacheAgeMs)
+
+        private fun findProcess(deviceId: String, name: String?, pid: Long, timeoutMs: Int, maxCacheAgeMs: Int) =
+            devices.withDevice(deviceId) { device ->
+                val reader = NativeReader(frida.fk_device_find_process(device, name, pid, timeoutMs, maxCacheAgeMs.toLong()))
+                reader.processes().firstOrNull()
             }
 
-            return appsIdentifiers
+        fun enumerateDevices(): List<Device> = devices.devices
+
+        fun deviceIcon(deviceId: String): Icon? =
+            devices.withDevice(deviceId) { frida.fk_icon_new_for_device(it) }?.let(::Icon)
+
+        fun querySystemParameters(deviceId: String): Map<String, Any?> = devices.systemParameters(deviceId)
+
+        fun spawn(deviceId: String, program: String, options: SpawnOptions? = null): Long =
+            devices.withDevice(deviceId) { device ->
+                val nativeOptions = options?.let { frida.fk_spawn_options_new(it.encode()) }
+                try {
+                    frida.frida_device_spawn_sync(device, program, nativeOptions)
+                } finally {
+                    nativeOptions?.let { frida.fk_spawn_options_unref(it) }
+                }
+            }
+
+        fun resume(deviceId: String, pid: Long) = devices.withDevice(deviceId) { device ->
+            frida.frida_device_resume_sync(device, pid)
+        }
+
+        fun kill(deviceId: String, pid: Long) = devices.withDevice(deviceId) { device ->
+            frida.frida_device_kill_sync(device, pid)
+            frida.fk_device_forget_processes(device)
         }
 
-        fun enumerateDevices(): List<Device> {
-            val devices = mutableListOf<Device>()
+        fun enumeratePendingSpawn(deviceId: String): List<Spawn> = devices.withDevice(deviceId) { device ->
+            val spawns = mutableListOf<Spawn>()
 
-            val deviceList = frida.frida_device_manager_enumerate_devices_sync(manager)
-            val size = frida.frida_device_list_size(deviceList)
+            val list = frida.frida_device_enumerate_pending_spawn_sync(device)
+            val size = frida.frida_spawn_list_size(list)
             for (i in 0 until size) {
-                val device = frida.frida_device_list_get(deviceList, i)
-                devices.add(
-                    Device(
-                        id = frida.frida_device_get_id(device),
-                        name = frida.frida_device_get_name(device),
-                        type = frida.frida_device_get_dtype(device)
+                val spawn = frida.frida_spawn_list_get(list, i)
+                spawns.add(
+                    Spawn(
+                        pid = frida.frida_spawn_get_pid(spawn),
+                        identifier = frida.frida_spawn_get_identifier(spawn)
                     )
                 )
+                frida.fk_spawn_unref(spawn)
             }
+            frida.fk_spawn_list_unref(list)
 
-            return devices
+            spawns
         }
+
+        fun enumeratePendingChildren(deviceId: String): List<Child> = devices.withDevice(deviceId) { device ->
+            val reader = NativeReader(frida.fk_device_enumerate_pending_children(device))
+            List(reader.u32().toInt()) { reader.child() }
+        }
+
+        fun <T> onAllDevices(
+            timeoutMs: Int = FanOut.DEFAULT_TIMEOUT_MS,
+            query: FanOut.Query.() -> FanOut.Request<T>
+        ): FanOut.Result<T> = FanOut.run(devices, timeoutMs, FanOut.Query.query())
     }
 
     data class Device(
@@ -69,6 +137,27 @@ class Frida {
     data class Application(
         val identifier: String,
         val name: String,
-        val pid : Long
+        val pid : Long,
+        val parameters: Map<String, Any?> = emptyMap()
+    )
+
+    data class Process(
+        val pid: Long,
+        val name: String,
+        val parameters: Map<String, Any?> = emptyMap()
+    )
+
+    data class Spawn(
+        val pid: Long,
+        val identifier: String?
+    )
+
+    data class Child(
+        val pid: Long,
+        val parentPid: Long,
+        val origin: FridaChildOrigin,
+        val identifier: String?,
+        val path: String?,
+        val argv: List<String>
     )
-}
\ No newline at end of file
+}
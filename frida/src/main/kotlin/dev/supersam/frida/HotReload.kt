@@ -0,0 +1,60 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+
+// Watches an agent's entrypoint with the frida compiler and reloads the agent
+// into every live session on each successful rebuild. Per-session results
+// arrive as Agent.Event.Reloaded / ReloadFailed on the agent itself.
+class HotReload(
+    agent: Agent,
+    queueCapacity: Int = DEFAULT_QUEUE_CAPACITY
+) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = frida.fk_hot_reload_new(Frida.devices.handle, agent.handle, queueCapacity.toLong())
+    private val events = EventQueue(frida.fk_hot_reload_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(List<Event>) -> Unit>()
+    private val pump = events.pump("frida-hot-reload") { batch ->
+        val decoded = batch.records.map { it.event() }
+        listeners.forEach { it(decoded) }
+    }
+
+    sealed class Event {
+        object Starting : Event()
+        object Finished : Event()
+        class Diagnostics(val diagnostics: Any?) : Event()
+        data class Output(val bundleSize: Long) : Event()
+    }
+
+    fun addListener(listener: (List<Event>) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (List<Event>) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun watch(entrypoint: String, projectRoot: String? = null): HotReload {
+        frida.fk_hot_reload_watch_sync(handle, entrypoint, projectRoot)
+        return this
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_hot_reload_free(handle)
+    }
+
+    companion object {
+        const val DEFAULT_QUEUE_CAPACITY = 1024 * 1024
+
+        private fun NativeReader.event(): Event = when (u8()) {
+            0 -> Event.Starting
+            1 -> Event.Finished
+            2 -> Event.Diagnostics(variant())
+            else -> Event.Output(u32())
+        }
+    }
+}
@@ -0,0 +1,21 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.SWIGTYPE_p__FkIcon
+import dev.supersam.fridaSource.frida
+import java.nio.ByteBuffer
+import java.util.concurrent.atomic.AtomicBoolean
+
+class Icon internal constructor(private val handle: SWIGTYPE_p__FkIcon) : AutoCloseable {
+    private val closed = AtomicBoolean()
+
+    val format: String = frida.fk_icon_get_format(handle)
+    val width: Int = frida.fk_icon_get_width(handle)
+    val height: Int = frida.fk_icon_get_height(handle)
+
+    // Points straight at the native image data; do not touch it after close().
+    val pixels: ByteBuffer = frida.fk_icon_get_pixels(handle).asReadOnlyBuffer()
+
+    override fun close() {
+        if (closed.compareAndSet(false, true)) frida.fk_icon_unref(handle)
+    }
+}
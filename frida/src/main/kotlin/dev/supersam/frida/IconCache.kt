@@ -0,0 +1,35 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.atomic.AtomicBoolean
+
+class IconCache(capacity: Int = DEFAULT_CAPACITY) : AutoCloseable {
+    init {
+        Frida.ensureInitialized()
+    }
+
+    private val closed = AtomicBoolean()
+    private val handle = frida.fk_icon_cache_new(capacity.toLong())
+
+    fun applicationIcon(device: Frida.Device, identifier: String, width: Int = LARGEST): Icon? =
+        Frida.devices.withDevice(device.id) { frida.fk_icon_cache_get_application_icon(handle, it, identifier, width) }
+            ?.let(::Icon)
+
+    fun prefetch(device: Frida.Device) {
+        Frida.devices.withDevice(device.id) { frida.fk_icon_cache_prefetch_applications(handle, it) }
+    }
+
+    fun clear() {
+        frida.fk_icon_cache_clear(handle)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        frida.fk_icon_cache_free(handle)
+    }
+
+    companion object {
+        const val DEFAULT_CAPACITY = 512
+        const val LARGEST = 0
+    }
+}
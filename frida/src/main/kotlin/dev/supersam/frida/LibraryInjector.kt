@@ -0,0 +1,99 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.SWIGTYPE_p__FkInjection
+import dev.supersam.fridaSource.frida
+import java.nio.ByteBuffer
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+
+class LibraryInjector private constructor(private val handle: SWIGTYPE_p__FkInjection) : AutoCloseable {
+    constructor(device: Frida.Device, queueCapacity: Int = DEFAULT_QUEUE_CAPACITY) :
+            this(Frida.devices.withDevice(device.id) { frida.fk_injection_new_for_device(it, queueCapacity.toLong()) })
+
+    private val closed = AtomicBoolean()
+    private val events = EventQueue(frida.fk_injection_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(Event) -> Unit>()
+    private val pump = events.pump("frida-injector") { batch ->
+        batch.records.forEach { record ->
+            val event = record.event()
+            listeners.forEach { it(event) }
+        }
+    }
+
+    sealed class Event {
+        data class Uninjected(val id: Long, val pid: Long) : Event()
+    }
+
+    inner class Blob internal constructor(val id: Long) : AutoCloseable {
+        private val released = AtomicBoolean()
+
+        fun inject(pid: Long, entrypoint: String, data: String = ""): Long =
+            frida.fk_injection_inject_blob_sync(handle, pid, id, entrypoint, data)
+
+        // Blobs with the same content share an id, each holding it once, so
+        // only the first close() may drop this holder's hold. Once the
+        // injector is closed every hold is gone along with the handle.
+        override fun close() {
+            if (!released.compareAndSet(false, true)) return
+            synchronized(this@LibraryInjector) {
+                if (!closed.get())
+                    frida.fk_injection_release_blob(handle, id)
+            }
+        }
+    }
+
+    val cachedBlobs: Long
+        get() = frida.fk_injection_get_blob_count(handle)
+
+    fun addListener(listener: (Event) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (Event) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun blob(library: ByteBuffer): Blob {
+        val direct = if (library.isDirect) library.slice()
+        else ByteBuffer.allocateDirect(library.remaining()).put(library.duplicate()).flip() as ByteBuffer
+        return Blob(frida.fk_injection_add_blob(handle, direct))
+    }
+
+    fun blob(library: ByteArray): Blob = blob(ByteBuffer.wrap(library))
+
+    fun blobFromFile(path: String): Blob = Blob(frida.fk_injection_add_blob_file(handle, path))
+
+    fun injectFile(pid: Long, path: String, entrypoint: String, data: String = ""): Long =
+        frida.fk_injection_inject_file_sync(handle, pid, path, entrypoint, data)
+
+    fun demonitor(id: Long) {
+        frida.fk_injection_demonitor_sync(handle, id)
+    }
+
+    fun recreateThread(pid: Long, id: Long) {
+        frida.fk_injection_recreate_thread_sync(handle, pid, id)
+    }
+
+    override fun close() {
+        // Taken under the monitor so a concurrent Blob.close() either finishes
+        // first or sees the injector closed.
+        if (!synchronized(this) { closed.compareAndSet(false, true) }) return
+        events.close()
+        pump.join()
+        frida.fk_injection_free(handle)
+    }
+
+    companion object {
+        const val DEFAULT_QUEUE_CAPACITY = 64 * 1024
+
+        fun local(inprocess: Boolean = false, queueCapacity: Int = DEFAULT_QUEUE_CAPACITY): LibraryInjector {
+            Frida.ensureInitialized()
+            return LibraryInjector(frida.fk_injection_new_local(inprocess, queueCapacity.toLong()))
+        }
+
+        private fun NativeReader.event(): Event {
+            u8()
+            return Event.Uninjected(id = u32(), pid = u32())
+        }
+    }
+}
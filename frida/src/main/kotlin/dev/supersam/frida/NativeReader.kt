@@ -0,0 +1,109 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FridaChildOrigin
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+internal class NativeReader(private val buffer: ByteBuffer) {
+    constructor(bytes: ByteArray) : this(ByteBuffer.wrap(bytes))
+
+    init {
+        buffer.order(ByteOrder.LITTLE_ENDIAN)
+    }
+
+    val hasRemaining: Boolean
+        get() = buffer.hasRemaining()
+
+    fun u8(): Int = buffer.get().toInt() and 0xff
+
+    fun bool(): Boolean = u8() != 0
+
+    fun u32(): Long = buffer.int.toLong() and 0xffffffffL
+
+    fun i32(): Int = buffer.int
+
+    fun i64(): Long = buffer.long
+
+    fun double(): Double = Double.fromBits(buffer.long)
+
+    fun string(): String? = bytes()?.toString(Charsets.UTF_8)
+
+    fun bytes(): ByteArray? {
+        val length = buffer.int
+        if (length == -1) return null
+        return ByteArray(length).also { buffer.get(it) }
+    }
+
+    fun slice(): ByteBuffer? {
+        val length = buffer.int
+        if (length == -1) return null
+        val view = buffer.slice().limit(length)
+        buffer.position(buffer.position() + length)
+        return view.order(ByteOrder.LITTLE_ENDIAN)
+    }
+
+    class Batch(val records: List<NativeReader>, val dropped: Long)
+
+    companion object {
+        fun batch(bytes: ByteArray): Batch {
+            val reader = NativeReader(bytes)
+            val count = reader.u32().toInt()
+            val dropped = reader.u32()
+            val records = List(count) { NativeReader(reader.slice()!!) }
+            return Batch(records, dropped)
+        }
+    }
+}
+
+internal fun NativeReader.applications(withParameters: Boolean = false): List<Frida.Application> =
+    List(u32().toInt()) {
+        Frida.Application(
+            identifier = string()!!,
+            name = string()!!,
+            pid = u32(),
+            parameters = if (withParameters) variantDict() else emptyMap()
+        )
+    }
+
+internal fun NativeReader.processes(withParameters: Boolean = false): List<Frida.Process> =
+    List(u32().toInt()) {
+        Frida.Process(
+            pid = u32(),
+            name = string()!!,
+            parameters = if (withParameters) variantDict() else emptyMap()
+        )
+    }
+
+internal fun NativeReader.child() = Frida.Child(
+    pid = u32(),
+    parentPid = u32(),
+    origin = FridaChildOrigin.swigToEnum(u8()),
+    identifier = string(),
+    path = string(),
+    argv = List(u32().toInt()) { string()!! }
+)
+
+// Values come back as String, Boolean, Long, Double, ByteArray, Map or List;
+// types with no Kotlin counterpart decode as null.
+internal fun NativeReader.variant(): Any? = when (u8()) {
+    1 -> string()
+    2 -> bool()
+    3 -> i64()
+    4 -> double()
+    5 -> bytes()
+    6 -> entries()
+    7 -> List(u32().toInt()) { variant() }
+    else -> null
+}
+
+internal fun NativeReader.variantDict(): Map<String, Any?> = entries()
+
+private fun NativeReader.entries(): Map<String, Any?> {
+    val count = u32().toInt()
+    val result = LinkedHashMap<String, Any?>(count)
+    repeat(count) {
+        val key = string()!!
+        result[key] = variant()
+    }
+    return result
+}
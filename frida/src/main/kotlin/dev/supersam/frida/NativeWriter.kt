@@ -0,0 +1,82 @@
+package dev.supersam.frida
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+internal class NativeWriter(initialCapacity: Int = 256) {
+    private var buffer = allocate(initialCapacity)
+
+    fun u8(value: Int) = apply {
+        ensure(1)
+        buffer.put(value.toByte())
+    }
+
+    fun u32(value: Int) = apply {
+        ensure(4)
+        buffer.putInt(value)
+    }
+
+    fun i64(value: Long) = apply {
+        ensure(8)
+        buffer.putLong(value)
+    }
+
+    fun f64(value: Double) = i64(value.toRawBits())
+
+    // Length-prefixed, as FkReader expects; -1 marks null.
+    fun bytes(value: ByteArray?) = apply {
+        if (value == null) {
+            u32(-1)
+            return@apply
+        }
+        u32(value.size)
+        ensure(value.size)
+        buffer.put(value)
+    }
+
+    fun string(value: String?) = bytes(value?.toByteArray(Charsets.UTF_8))
+
+    // Mirror of NativeReader.variant(), decoded natively by fk_read_variant.
+    fun variant(value: Any?): NativeWriter = apply {
+        when (value) {
+            null -> u8(0)
+            is String -> u8(1).string(value)
+            is Boolean -> u8(2).u8(if (value) 1 else 0)
+            is Int, is Long, is Short, is Byte -> u8(3).i64((value as Number).toLong())
+            is Double, is Float -> u8(4).f64((value as Number).toDouble())
+            is ByteArray -> u8(5).bytes(value)
+            is Map<*, *> -> {
+                u8(6).u32(value.size)
+                value.forEach { (k, v) -> string(k as String).variant(v) }
+            }
+            is Collection<*> -> {
+                u8(7).u32(value.size)
+                value.forEach { variant(it) }
+            }
+            is Array<*> -> variant(value.asList())
+            else -> throw IllegalArgumentException("Unsupported variant value: ${value::class}")
+        }
+    }
+
+    fun cstring(value: ByteArray) = apply {
+        ensure(value.size + 1)
+        buffer.put(value)
+        buffer.put(0)
+    }
+
+    fun cstring(value: String) = cstring(value.toByteArray(Charsets.UTF_8))
+
+    fun finish(): ByteBuffer = buffer.flip().slice().order(ByteOrder.LITTLE_ENDIAN)
+
+    private fun ensure(size: Int) {
+        if (buffer.remaining() >= size) return
+        val grown = allocate(maxOf(buffer.capacity() * 2, buffer.position() + size))
+        buffer.flip()
+        grown.put(buffer)
+        buffer = grown
+    }
+
+    private companion object {
+        fun allocate(capacity: Int): ByteBuffer = ByteBuffer.allocateDirect(capacity).order(ByteOrder.LITTLE_ENDIAN)
+    }
+}
@@ -0,0 +1,32 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FridaRelayKind
+import dev.supersam.fridaSource.SWIGTYPE_p__FridaPeerOptions
+import dev.supersam.fridaSource.frida
+
+// Options for upgrading sessions to a direct peer connection. Relays are
+// TURN servers used when no direct path can be negotiated; a local TURN
+// server works as a stand-in for testing.
+data class PeerOptions(
+    val stunServer: String? = null,
+    val relays: List<Relay> = emptyList()
+) {
+    data class Relay(
+        val address: String,
+        val username: String,
+        val password: String,
+        val kind: FridaRelayKind = FridaRelayKind.FRIDA_RELAY_KIND_TURN_UDP
+    )
+
+    enum class Transport { CONTROL, PEER, DETACHED }
+
+    internal fun <T> withNative(block: (SWIGTYPE_p__FridaPeerOptions) -> T): T {
+        val options = frida.fk_peer_options_new(stunServer)
+        try {
+            relays.forEach { frida.fk_peer_options_add_relay(options, it.address, it.username, it.password, it.kind) }
+            return block(options)
+        } finally {
+            frida.fk_peer_options_unref(options)
+        }
+    }
+}
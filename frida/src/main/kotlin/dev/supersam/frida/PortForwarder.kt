@@ -0,0 +1,59 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.atomic.AtomicBoolean
+
+class PortForwarder(
+    device: Frida.Device,
+    remoteAddress: String,
+    localPort: Int = 0,
+    localAddress: String = "127.0.0.1"
+) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = Frida.devices.withDevice(device.id) {
+        frida.fk_forwarder_new(it, remoteAddress, localAddress, localPort)
+    }
+
+    val port: Int = frida.fk_forwarder_get_port(handle)
+
+    data class Stats(
+        val accepted: Long,
+        val active: Long,
+        val failed: Long,
+        val bytesToDevice: Long,
+        val bytesFromDevice: Long,
+        val openMicrosTotal: Long,
+        val openMicrosMax: Long,
+        val chunks: Long,
+        val chunkMicrosTotal: Long,
+        val chunkMicrosMax: Long
+    ) {
+        val openMicrosAverage: Long
+            get() = if (accepted - failed > 0) openMicrosTotal / (accepted - failed) else 0
+
+        val chunkMicrosAverage: Long
+            get() = if (chunks > 0) chunkMicrosTotal / chunks else 0
+    }
+
+    val stats: Stats
+        get() {
+            val reader = NativeReader(frida.fk_forwarder_get_stats(handle))
+            return Stats(
+                accepted = reader.i64(),
+                active = reader.i64(),
+                failed = reader.i64(),
+                bytesToDevice = reader.i64(),
+                bytesFromDevice = reader.i64(),
+                openMicrosTotal = reader.i64(),
+                openMicrosMax = reader.i64(),
+                chunks = reader.i64(),
+                chunkMicrosTotal = reader.i64(),
+                chunkMicrosMax = reader.i64()
+            )
+        }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        frida.fk_forwarder_free(handle)
+    }
+}
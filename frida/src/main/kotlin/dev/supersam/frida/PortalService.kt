@@ -0,0 +1,139 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicLong
+
+class PortalService(
+    cluster: Endpoint = Endpoint(port = DEFAULT_CLUSTER_PORT),
+    control: Endpoint? = null,
+    queueCapacity: Int = DEFAULT_QUEUE_CAPACITY
+) : AutoCloseable {
+    init {
+        Frida.ensureInitialized()
+    }
+
+    private val clusterParams = cluster.create()
+    private val controlParams = control?.create()
+    private val closed = AtomicBoolean()
+    private val handle = frida.fk_portal_new(clusterParams, controlParams, queueCapacity.toLong())
+    private val service = frida.fk_portal_get_service(handle)
+    private val events = EventQueue(frida.fk_portal_get_events(handle))
+    private var started = false
+    private val listeners = CopyOnWriteArrayList<(List<Event>) -> Unit>()
+    private val dropped = AtomicLong()
+    private val pump = events.pump("frida-portal") { batch ->
+        dropped.addAndGet(batch.dropped)
+        val decoded = batch.records.map { it.event() }
+        listeners.forEach { it(decoded) }
+    }
+
+    sealed class Event {
+        abstract val connectionId: Long
+
+        data class NodeConnected(override val connectionId: Long, val address: String?) : Event()
+        data class NodeJoined(override val connectionId: Long, val application: Frida.Application) : Event()
+        data class NodeLeft(override val connectionId: Long, val application: Frida.Application) : Event()
+        data class NodeDisconnected(override val connectionId: Long, val address: String?) : Event()
+        data class ControllerConnected(override val connectionId: Long, val address: String?) : Event()
+        data class ControllerDisconnected(override val connectionId: Long, val address: String?) : Event()
+        data class Authenticated(override val connectionId: Long, val sessionInfo: String) : Event()
+        data class Subscribe(override val connectionId: Long) : Event()
+        class Message(override val connectionId: Long, val json: String, val data: ByteArray?) : Event()
+    }
+
+    val droppedEvents: Long
+        get() = dropped.get()
+
+    fun addListener(listener: (List<Event>) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (List<Event>) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    @Synchronized
+    fun start(): PortalService {
+        if (!started) {
+            frida.frida_portal_service_start_sync(service)
+            started = true
+        }
+        return this
+    }
+
+    @Synchronized
+    fun stop() {
+        if (started) {
+            frida.frida_portal_service_stop_sync(service)
+            started = false
+        }
+    }
+
+    fun post(connectionId: Long, json: String, data: ByteArray? = null) {
+        frida.frida_portal_service_post(service, connectionId, json, data)
+    }
+
+    fun narrowcast(tag: String, json: String, data: ByteArray? = null) {
+        frida.frida_portal_service_narrowcast(service, tag, json, data)
+    }
+
+    fun broadcast(json: String, data: ByteArray? = null) {
+        frida.frida_portal_service_broadcast(service, json, data)
+    }
+
+    fun tag(connectionId: Long, tag: String) {
+        frida.frida_portal_service_tag(service, connectionId, tag)
+    }
+
+    fun untag(connectionId: Long, tag: String) {
+        frida.frida_portal_service_untag(service, connectionId, tag)
+    }
+
+    fun tags(connectionId: Long): List<String> {
+        val reader = NativeReader(frida.fk_portal_enumerate_tags(handle, connectionId))
+        return List(reader.u32().toInt()) { reader.string()!! }
+    }
+
+    fun kick(connectionId: Long) {
+        frida.frida_portal_service_kick(service, connectionId)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        stop()
+        events.close()
+        pump.join()
+        frida.fk_portal_free(handle)
+        controlParams?.let(frida::fk_endpoint_parameters_unref)
+        frida.fk_endpoint_parameters_unref(clusterParams)
+    }
+
+    companion object {
+        const val DEFAULT_CLUSTER_PORT = 27052
+        const val DEFAULT_QUEUE_CAPACITY = 16 * 1024 * 1024
+
+        private fun NativeReader.application() = Frida.Application(
+            identifier = string()!!,
+            name = string()!!,
+            pid = u32()
+        )
+
+        private fun NativeReader.event(): Event {
+            val kind = u8()
+            val id = u32()
+            return when (kind) {
+                0 -> Event.NodeConnected(id, string())
+                1 -> Event.NodeJoined(id, application())
+                2 -> Event.NodeLeft(id, application())
+                3 -> Event.NodeDisconnected(id, string())
+                4 -> Event.ControllerConnected(id, string())
+                5 -> Event.ControllerDisconnected(id, string())
+                6 -> Event.Authenticated(id, string() ?: "")
+                7 -> Event.Subscribe(id)
+                else -> Event.Message(id, string()!!, bytes())
+            }
+        }
+    }
+}
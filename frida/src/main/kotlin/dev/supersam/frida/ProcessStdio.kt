@@ -0,0 +1,136 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FkStdioCaptureStatus
+import dev.supersam.fridaSource.FkStdioCaptureStreams
+import dev.supersam.fridaSource.frida
+import java.io.IOException
+import java.nio.ByteBuffer
+import java.nio.channels.AsynchronousCloseException
+import java.nio.channels.ClosedChannelException
+import java.nio.channels.ReadableByteChannel
+import java.nio.channels.WritableByteChannel
+import java.util.concurrent.locks.ReentrantReadWriteLock
+import kotlin.concurrent.read
+import kotlin.concurrent.write
+
+// Streams stdio of processes spawned with FridaStdio.FRIDA_STDIO_PIPE. Output
+// is buffered natively, bufferCapacity bytes per watched stream. Frida's output
+// signal offers no way to slow the process down, so upstream backpressure is
+// impossible: output that arrives while a buffer is full is dropped rather
+// than holding up frida. The loss is never silent, though: once a reader gets
+// to it, read() throws OutputLostException, and reading again resumes with
+// what arrived after the gap. Watch only the streams that will be read, and
+// size the buffer for how far readers may fall behind.
+class ProcessStdio(
+    device: Frida.Device,
+    bufferCapacity: Int = 1 shl 20
+) : AutoCloseable {
+    private val handle = Frida.devices.withDevice(device.id) {
+        frida.fk_stdio_capture_new(it, bufferCapacity.toLong())
+    }
+    private val lifecycle = ReentrantReadWriteLock()
+    private var freed = false
+
+    fun watch(pid: Long, stdout: Boolean = true, stderr: Boolean = true) {
+        val streams = (if (stdout) FkStdioCaptureStreams.FK_STDIO_CAPTURE_STDOUT.swigValue() else 0) or
+                (if (stderr) FkStdioCaptureStreams.FK_STDIO_CAPTURE_STDERR.swigValue() else 0)
+        native { frida.fk_stdio_capture_watch(handle, pid, streams) }
+    }
+
+    fun unwatch(pid: Long) = native { frida.fk_stdio_capture_unwatch(handle, pid) }
+
+    fun stdout(pid: Long): ReadableByteChannel = OutputChannel(pid, 1)
+
+    fun stderr(pid: Long): ReadableByteChannel = OutputChannel(pid, 2)
+
+    fun stdin(pid: Long): WritableByteChannel = InputChannel(pid)
+
+    class OutputLostException(val pid: Long, val fd: Int, val lostBytes: Long) :
+        IOException("$lostBytes bytes of output on fd $fd of pid $pid were dropped")
+
+    fun droppedBytes(pid: Long, fd: Int): Long = native { frida.fk_stdio_capture_get_dropped(handle, pid, fd) }
+
+    override fun close() {
+        lifecycle.read {
+            if (!freed) frida.fk_stdio_capture_close(handle)
+        }
+        lifecycle.write {
+            if (!freed) {
+                freed = true
+                frida.fk_stdio_capture_free(handle)
+            }
+        }
+    }
+
+    private fun <T> native(block: () -> T): T = lifecycle.read {
+        if (freed) throw ClosedChannelException()
+        block()
+    }
+
+    private inner class OutputChannel(private val pid: Long, private val fd: Int) : ReadableByteChannel {
+        @Volatile
+        private var open = true
+        private var scratch: ByteBuffer? = null
+
+        override fun read(dst: ByteBuffer): Int {
+            if (!open) throw ClosedChannelException()
+            if (!dst.hasRemaining()) return 0
+
+            val target = if (dst.isDirect) dst.slice() else scratch(dst.remaining())
+            while (true) {
+                // Wake up periodically so a closed channel does not block forever.
+                val n = native { frida.fk_stdio_capture_read(handle, pid, fd, target, POLL_INTERVAL_MS) }
+                when {
+                    n == 0 && !open -> throw AsynchronousCloseException()
+                    n == 0 -> continue
+                    n == LOST -> throw OutputLostException(pid, fd, native {
+                        frida.fk_stdio_capture_skip_lost(handle, pid, fd)
+                    })
+                    n < 0 -> return -1
+                    dst.isDirect -> dst.position(dst.position() + n)
+                    else -> dst.put(target.limit(n) as ByteBuffer)
+                }
+                return n
+            }
+        }
+
+        private fun scratch(size: Int): ByteBuffer {
+            val buffer = scratch?.takeIf { it.capacity() >= minOf(size, SCRATCH_SIZE) }
+                ?: ByteBuffer.allocateDirect(minOf(size, SCRATCH_SIZE)).also { scratch = it }
+            buffer.clear().limit(minOf(size, buffer.capacity()))
+            return buffer.slice()
+        }
+
+        override fun isOpen() = open
+
+        override fun close() {
+            open = false
+        }
+    }
+
+    private inner class InputChannel(private val pid: Long) : WritableByteChannel {
+        @Volatile
+        private var open = true
+
+        override fun write(src: ByteBuffer): Int {
+            if (!open) throw ClosedChannelException()
+            val n = src.remaining()
+            val data = if (src.isDirect) src.slice() else ByteBuffer.allocateDirect(n).put(src.duplicate()).flip() as ByteBuffer
+            native { frida.fk_stdio_capture_input(handle, pid, data) }
+            src.position(src.position() + n)
+            return n
+        }
+
+        override fun isOpen() = open
+
+        override fun close() {
+            open = false
+        }
+    }
+
+    private companion object {
+        const val POLL_INTERVAL_MS = 250
+        const val SCRATCH_SIZE = 64 * 1024
+        val LOST = FkStdioCaptureStatus.FK_STDIO_CAPTURE_LOST.swigValue()
+    }
+}
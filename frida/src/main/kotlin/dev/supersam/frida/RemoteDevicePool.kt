@@ -0,0 +1,94 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FridaDeviceType
+import dev.supersam.fridaSource.SWIGTYPE_p__FridaDeviceManager
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+
+class RemoteDevicePool internal constructor(manager: SWIGTYPE_p__FridaDeviceManager) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = frida.fk_remote_pool_new(manager)
+    private val events = EventQueue(frida.fk_remote_pool_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(Event) -> Unit>()
+    private val pump = events.pump("frida-remote-pool") { batch ->
+        batch.records.forEach { record ->
+            val event = record.event()
+            listeners.forEach { it(event) }
+        }
+    }
+
+    data class Options(
+        val certificate: String? = null,
+        val origin: String? = null,
+        val token: String? = null,
+        val keepaliveInterval: Int = DEFAULT_KEEPALIVE_INTERVAL
+    )
+
+    sealed class Event {
+        abstract val address: String
+
+        data class Lost(override val address: String, val deviceId: String?) : Event()
+        data class Reconnected(override val address: String, val deviceId: String) : Event()
+        data class ReconnectFailed(override val address: String, val attempt: Long, val message: String) : Event()
+    }
+
+    fun add(address: String, options: Options = Options()): Frida.Device {
+        val device = frida.fk_remote_pool_add(
+            handle,
+            address,
+            options.certificate,
+            options.origin,
+            options.token,
+            options.keepaliveInterval
+        )
+        try {
+            return Frida.Device(
+                id = frida.frida_device_get_id(device),
+                name = frida.frida_device_get_name(device),
+                type = FridaDeviceType.FRIDA_DEVICE_TYPE_REMOTE
+            )
+        } finally {
+            frida.fk_device_unref(device)
+        }
+    }
+
+    fun remove(address: String) {
+        frida.fk_remote_pool_remove(handle, address)
+    }
+
+    fun addListener(listener: (Event) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (Event) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_remote_pool_free(handle)
+    }
+
+    companion object {
+        const val DEFAULT_KEEPALIVE_INTERVAL = 10
+
+        private const val LOST = 0
+        private const val RECONNECTED = 1
+
+        private fun NativeReader.event(): Event {
+            val kind = u8()
+            val address = string()!!
+            val deviceId = string()
+            val attempt = u32()
+            val message = string()
+            return when (kind) {
+                LOST -> Event.Lost(address, deviceId)
+                RECONNECTED -> Event.Reconnected(address, deviceId!!)
+                else -> Event.ReconnectFailed(address, attempt, message ?: "")
+            }
+        }
+    }
+}
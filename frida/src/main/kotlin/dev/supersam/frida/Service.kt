@@ -0,0 +1,82 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.SWIGTYPE_p__FkService
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+
+// A platform service opened on a device, e.g. "xpc:com.apple.coredevice.appservice".
+// Requests are pipelined: request() returns immediately and its future is
+// completed from the event pump, so callers can keep many in flight.
+// Parameters and responses are plain values: String, Boolean, Long, Double,
+// ByteArray, Map<String, *> and List<*>.
+class Service private constructor(private val handle: SWIGTYPE_p__FkService) : AutoCloseable {
+    private val events = EventQueue(frida.fk_service_get_events(handle))
+    private val pending = ConcurrentHashMap<Long, CompletableFuture<Any?>>()
+    private val listeners = CopyOnWriteArrayList<(List<Any?>) -> Unit>()
+    private val closed = AtomicBoolean()
+    private val pump = events.pump("frida-service") { batch ->
+        val messages = ArrayList<Any?>()
+        for (record in batch.records) {
+            when (record.u8()) {
+                0 -> take(record.u32())?.complete(record.variant())
+                1 -> take(record.u32())?.completeExceptionally(RuntimeException(record.string()))
+                2 -> messages.add(record.variant())
+                else -> failPending("Service closed")
+            }
+        }
+        if (messages.isNotEmpty()) listeners.forEach { it(messages) }
+    }
+
+    val isClosed: Boolean
+        get() = closed.get() || frida.fk_service_is_closed(handle)
+
+    // Listeners receive every message delivered since the previous batch.
+    fun addMessageListener(listener: (List<Any?>) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeMessageListener(listener: (List<Any?>) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun request(parameters: Any?): CompletableFuture<Any?> {
+        val future = CompletableFuture<Any?>()
+        if (closed.get()) {
+            future.completeExceptionally(IllegalStateException("Service closed"))
+            return future
+        }
+        val encoded = NativeWriter().variant(parameters).finish()
+        // The id is only known once the request has been started; holding
+        // the lock keeps the pump from seeing its completion first.
+        synchronized(pending) {
+            val id = frida.fk_service_request(handle, encoded)
+            pending[id] = future
+        }
+        return future
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_service_free(handle)
+        failPending("Service closed")
+    }
+
+    private fun take(id: Long) = synchronized(pending) { pending.remove(id) }
+
+    private fun failPending(reason: String) {
+        synchronized(pending) {
+            pending.values.forEach { it.completeExceptionally(IllegalStateException(reason)) }
+            pending.clear()
+        }
+    }
+
+    companion object {
+        fun open(device: Frida.Device, address: String): Service =
+            Service(Frida.devices.withDevice(device.id) { frida.fk_service_open_sync(it, address) })
+    }
+}
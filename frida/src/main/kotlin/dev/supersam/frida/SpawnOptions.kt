@@ -0,0 +1,67 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.FridaStdio
+import java.nio.ByteBuffer
+
+data class SpawnOptions(
+    val argv: List<String>? = null,
+    val envp: Map<String, String>? = null,
+    val env: Map<String, String>? = null,
+    val cwd: String? = null,
+    val stdio: FridaStdio? = null,
+    val aux: Map<String, Any> = emptyMap()
+) {
+    internal fun encode(): ByteBuffer {
+        val encodedArgv = argv?.map { it.toByteArray(Charsets.UTF_8) }
+        val encodedEnvp = envp?.entries?.map { "${it.key}=${it.value}".toByteArray(Charsets.UTF_8) }
+        val encodedEnv = env?.entries?.map { "${it.key}=${it.value}".toByteArray(Charsets.UTF_8) }
+        val encodedCwd = cwd?.toByteArray(Charsets.UTF_8)
+
+        // Sized up front so the strings are written once, straight into the direct buffer.
+        val vectors = listOfNotNull(encodedArgv, encodedEnvp, encodedEnv)
+        val size = 32 + vectors.sumOf { vector -> 4 + vector.sumOf { it.size + 1 } } +
+            (encodedCwd?.size ?: 0) + aux.size * 64
+
+        val writer = NativeWriter(size)
+        writer.u32(
+            (if (encodedArgv != null) ARGV else 0) or
+                (if (encodedEnvp != null) ENVP else 0) or
+                (if (encodedEnv != null) ENV else 0) or
+                (if (encodedCwd != null) CWD else 0) or
+                (if (stdio != null) STDIO else 0) or
+                (if (aux.isNotEmpty()) AUX else 0)
+        )
+        vectors.forEach { vector ->
+            writer.u32(vector.size)
+            vector.forEach(writer::cstring)
+        }
+        encodedCwd?.let(writer::cstring)
+        stdio?.let { writer.u32(it.swigValue()) }
+        if (aux.isNotEmpty()) {
+            writer.u32(aux.size)
+            aux.forEach { (key, value) ->
+                writer.cstring(key)
+                when (value) {
+                    is String -> writer.u8(AUX_STRING).cstring(value)
+                    is Boolean -> writer.u8(AUX_BOOLEAN).u8(if (value) 1 else 0)
+                    is Int, is Long -> writer.u8(AUX_INT64).i64((value as Number).toLong())
+                    else -> throw IllegalArgumentException("Unsupported aux value for $key: ${value::class}")
+                }
+            }
+        }
+        return writer.finish()
+    }
+
+    private companion object {
+        const val ARGV = 1 shl 0
+        const val ENVP = 1 shl 1
+        const val ENV = 1 shl 2
+        const val CWD = 1 shl 3
+        const val STDIO = 1 shl 4
+        const val AUX = 1 shl 5
+
+        const val AUX_STRING = 0
+        const val AUX_BOOLEAN = 1
+        const val AUX_INT64 = 2
+    }
+}
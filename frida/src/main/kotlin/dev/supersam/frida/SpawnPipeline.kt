@@ -0,0 +1,84 @@
+package dev.supersam.frida
+
+import dev.supersam.fridaSource.frida
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.concurrent.atomic.AtomicBoolean
+
+class SpawnPipeline(
+    device: Frida.Device,
+    agent: Agent,
+    identifiers: Set<String> = emptySet()
+) : AutoCloseable {
+    private val closed = AtomicBoolean()
+    private val handle = Frida.devices.withDevice(device.id) { frida.fk_spawn_pipeline_new(it, agent.handle) }
+    private val events = EventQueue(frida.fk_spawn_pipeline_get_events(handle))
+    private val listeners = CopyOnWriteArrayList<(Event) -> Unit>()
+    private val pump = events.pump("frida-spawn-pipeline") { batch ->
+        batch.records.forEach { record ->
+            val event = record.event()
+            listeners.forEach { it(event) }
+        }
+    }
+
+    init {
+        identifiers.forEach { frida.fk_spawn_pipeline_add_identifier(handle, it) }
+    }
+
+    sealed class Event {
+        abstract val pid: Long
+        abstract val identifier: String?
+        abstract val elapsedMicros: Long
+
+        data class Added(override val pid: Long, override val identifier: String?, override val elapsedMicros: Long) : Event()
+        data class Instrumented(override val pid: Long, override val identifier: String?, override val elapsedMicros: Long) : Event()
+        data class Resumed(override val pid: Long, override val identifier: String?, override val elapsedMicros: Long) : Event()
+        data class Skipped(override val pid: Long, override val identifier: String?, override val elapsedMicros: Long) : Event()
+        data class Failed(
+            override val pid: Long,
+            override val identifier: String?,
+            override val elapsedMicros: Long,
+            val message: String
+        ) : Event()
+    }
+
+    fun addListener(listener: (Event) -> Unit) {
+        listeners.add(listener)
+    }
+
+    fun removeListener(listener: (Event) -> Unit) {
+        listeners.remove(listener)
+    }
+
+    fun start(): SpawnPipeline {
+        frida.fk_spawn_pipeline_start_sync(handle)
+        return this
+    }
+
+    fun stop() {
+        frida.fk_spawn_pipeline_stop_sync(handle)
+    }
+
+    override fun close() {
+        if (!closed.compareAndSet(false, true)) return
+        events.close()
+        pump.join()
+        frida.fk_spawn_pipeline_free(handle)
+    }
+
+    private companion object {
+        fun NativeReader.event(): Event {
+            val kind = u8()
+            val pid = u32()
+            val identifier = string()
+            val error = string()
+            val elapsed = i64()
+            return when (kind) {
+                0 -> Event.Added(pid, identifier, elapsed)
+                1 -> Event.Instrumented(pid, identifier, elapsed)
+                2 -> Event.Resumed(pid, identifier, elapsed)
+                3 -> Event.Skipped(pid, identifier, elapsed)
+                else -> Event.Failed(pid, identifier, elapsed, error ?: "")
+            }
+        }
+    }
+}